@@ -40,8 +40,12 @@
 #define DEFAULT_EXP_SMOOTHING           ((float) 0.09)
 #define DEFAULT_ONE_EU_BETA             ((float) 0.003)
 #define DEFAULT_NOTE_DEBOUNCE_INTERVAL  ((float) 115.0)
+#define TUNER_NOTE_DEBOUNCE_MIN         100 // Milliseconds (the Name Debouncing spinbox's range)
+#define TUNER_NOTE_DEBOUNCE_MAX         500
 #define DEFAULT_USE_1EU_FILTER_FIRST    (true)
-// #define DEFAULT_MOVING_AVG_WINDOW       ((float) 100)
+#define DEFAULT_DETECTOR_PROFILE_INDEX  ((uint8_t) 1) // Standard 48kHz (see detector_profiles.h)
+#define DEFAULT_READING_FILTER_TYPE     ((uint8_t) 0) // None (see reading_filters.hpp)
+#define DEFAULT_READING_FILTER_WINDOW   ((float) 5)
 #define DEFAULT_DISPLAY_BRIGHTNESS      ((float) 0.75)
 
 //
@@ -66,11 +70,62 @@
 
 // CYD @ 48kHz
 #define TUNER_ADC_FRAME_SIZE            1024
-#define TUNER_ADC_BUFFER_POOL_SIZE      4096
 #define TUNER_ADC_SAMPLE_RATE           (48 * 1000) // 48kHz
 
-/// @brief This factor is used to correct the incoming frequency readings on ESP32-WROOM-32 (which CYD is). This same weird behavior does not happen on ESP32-S2 or ESP32-S3.
-#define WEIRD_ESP32_WROOM_32_FREQ_FIX_FACTOR    1.2222222223 // 11/9 but using 11/9 gives completely incorrect results. Weird.
+// Number of samples in each frame (each type1 ADC result is 2 bytes, see SOC_ADC_DIGI_RESULT_BYTES)
+#define TUNER_ADC_FRAME_SAMPLES         (TUNER_ADC_FRAME_SIZE / 2)
+
+// The conversion-done ISR copies every frame into a ring so the detector sees
+// a gap-free stream. The ring is mirrored (2 x 2 bytes per sample), so 4096
+// samples takes 16KB. Must be a power of two.
+#define TUNER_SAMPLE_RING_SAMPLES       4096
+
+// The detector analyzes TUNER_DETECTOR_WINDOW_SAMPLES at a time and moves
+// forward a frame each time. Make the window larger than the frame to overlap
+// windows (the noise gate and normalization then cover more of a low note).
+// This is the standard profile's window. The profiles in
+// detector/detector_profiles.cpp can be picked at runtime and each sets its
+// own frame and window.
+#define TUNER_DETECTOR_WINDOW_SAMPLES   TUNER_ADC_FRAME_SAMPLES
+
+// Optional anti-alias filter and downsampling in front of q::pitch_detector.
+// The detector's highest frequency is C7 (~2093Hz), so 4 (48kHz -> 12kHz)
+// still leaves room for a few harmonics and cuts the detector's work by 4x.
+// 1 turns it off. The filter is TUNER_DECIMATOR_TAPS_PER_PHASE x the factor
+// taps long and passes up to TUNER_DECIMATOR_CUTOFF of the new Nyquist.
+#define TUNER_DETECTOR_DECIMATION_FACTOR    1
+#define TUNER_DECIMATOR_TAPS_PER_PHASE      8
+#define TUNER_DECIMATOR_CUTOFF              0.8f
+
+// Octave guard (see detector/octave_guard.h). Catches the detector jumping to
+// a harmonic (or a fifth) of the note for a reading or two as a string decays.
+#define TUNER_OCTAVE_GUARD_ENABLED                  1
+#define TUNER_OCTAVE_GUARD_HISTORY                  7       // Accepted readings the reference pitch is the median of
+#define TUNER_OCTAVE_GUARD_MIN_HISTORY              3       // Accepted readings needed before jumps are checked
+#define TUNER_OCTAVE_GUARD_TOLERANCE_CENTS          50.0f   // How close a jump has to be to a harmonic or fifth
+#define TUNER_OCTAVE_GUARD_MIN_PERIODICITY          0.7f    // Needed to jump anywhere other than a harmonic
+#define TUNER_OCTAVE_GUARD_CONFIDENT_PERIODICITY    0.9f    // Needed to confirm a harmonic jump is a real note change
+#define TUNER_OCTAVE_GUARD_CONFIRM_READINGS         6       // Readings in a row a harmonic jump has to hold for
+
+// Number format for normalization, smoothing, and cents (see utils/numeric_policy.hpp).
+// TUNER_NUMERIC_FLOAT (0) or TUNER_NUMERIC_FIXED (1).
+#define TUNER_NUMERIC_POLICY                0
+
+// Frames to let go by after boot before the heap watermark baseline is taken
+#define TUNER_HEAP_WATERMARK_WARMUP_FRAMES  100
+
+// The ESP32-WROOM-32's ADC (which the CYD has) doesn't really sample at the
+// rate it's asked for. Readings used to be divided by 1.2222222223 to make up
+// for it. The same thing as a sample clock correction is the real rate / the
+// asked-for rate, which the pitch pipeline applies to its sample rate once.
+// This is only the starting point. Settings > Advanced > Calibrate Clock
+// measures it for each device at the selected profile's sample rate and saves
+// it in NVS for that rate only (the error isn't the same at every rate).
+// ESP32-S2 and ESP32-S3 should measure close to 1.0.
+#define DEFAULT_SAMPLE_CLOCK_CORRECTION     ((float) (1.0 / 1.2222222223))
+#define TUNER_CLOCK_CALIBRATION_MS          5000    // How long Calibrate Clock counts samples for
+#define TUNER_CLOCK_CORRECTION_MIN          0.5f    // Anything outside of this is a broken measurement
+#define TUNER_CLOCK_CORRECTION_MAX          1.5f
 
 // HELTEC @ 20kHz
 // #define TUNER_ADC_FRAME_SIZE            (SOC_ADC_DIGI_DATA_BYTES_PER_CONV * 256)
@@ -82,13 +137,33 @@
 // #define TUNER_ADC_BUFFER_POOL_SIZE      (TUNER_ADC_FRAME_SIZE * 4)
 // #define TUNER_ADC_SAMPLE_RATE           (5 * 1000) // 5kHz
 
-// If the difference between the minimum and maximum input values
-// is less than this value, discard the reading and do not evaluate
-// the frequency. This should help cut down on the noise from the
-// OLED and only attempt to read frequency information when an
-// actual input signal is being read.
-// #define TUNER_READING_DIFF_MINIMUM      400 // TODO: Convert this into a debug setting
-#define TUNER_READING_DIFF_MINIMUM      300 // TODO: Convert this into a debug setting
+// Noise gate (see detector/noise_gate.h). Frames are only sent to the
+// detector while the gate is open. Levels are the RMS of a window in ADC
+// counts. The noise floor is learned while the gate is closed, and the gate
+// opens TUNER_NOISE_GATE_ONSET_DB above it and closes again
+// TUNER_NOISE_GATE_RELEASE_DB above it. The starting floor puts the onset
+// about where the old fixed 300 count peak-to-peak minimum was.
+#define TUNER_NOISE_GATE_INITIAL_FLOOR  25.0f
+#define TUNER_NOISE_GATE_MIN_FLOOR      4.0f    // Keeps a very quiet board from opening on nothing
+#define TUNER_NOISE_GATE_MAX_FLOOR      150.0f  // Keeps a long quiet note from teaching the gate to ignore playing
+#define TUNER_NOISE_GATE_ONSET_DB       12.0f
+#define TUNER_NOISE_GATE_RELEASE_DB     6.0f
+#define TUNER_NOISE_GATE_RELEASE_MS     80.0f   // Envelope decay (the attack is instant)
+#define TUNER_NOISE_GATE_FLOOR_RISE_MS  3000.0f // How slowly the floor follows louder noise
+#define TUNER_NOISE_GATE_FLOOR_FALL_MS  300.0f  // ... and quieter noise
+
+// Once the gate has let a window through, it's still only normalized and
+// handed to the detector if its peak-to-peak range (in ADC counts) is at least
+// this. Quieter windows (the gate's release, the re-lock hold) go to the
+// detector as silence rather than noise stretched to full scale.
+#define TUNER_DETECTOR_MIN_PEAK_TO_PEAK 32
+
+// After the gate closes the detector keeps running (without publishing) and
+// nothing is reset for this long, so re-plucking a string picks up where the
+// last pluck left off instead of starting the detector over. 0 resets as
+// soon as the gate closes.
+#define TUNER_RELOCK_HOLD_MS            300.0f
+#define TUNER_RELOCK_TOLERANCE_CENTS    50.0f   // A re-pluck further than this from the last reading starts the filters over
 
 //
 // Smoothing
@@ -99,6 +174,11 @@
 #define EU_FILTER_MIN_CUTOFF            0.5
 #define EU_FILTER_DERIVATIVE_CUTOFF     1
 
+// Reading filters (see reading_filters.hpp). These run on every detected
+// period, so the window is counted in readings, not samples.
+#define TUNER_READING_FILTER_MAX_WINDOW 31
+#define TUNER_HAMPEL_THRESHOLD          3.0f // Scaled MADs from the median before a reading is an outlier
+
 //
 // GUI Related
 //
@@ -108,6 +188,20 @@
 
 #define INDICATOR_SEGMENTS              100 // num of visual segments for showing tuning accuracy
 
+// The GUI task sleeps until the pitch detector publishes a new result. These
+// limit how often it redraws and how long it sleeps when nothing arrives.
+#define TUNER_GUI_MAX_FPS               30  // LV_DEF_REFR_PERIOD is 33ms so more than this is wasted
+#define TUNER_GUI_IDLE_TIMEOUT_MS       200
+#define TUNER_GUI_LATENCY_LOG_INTERVAL  100 // Log ADC-to-flush latency every this many measurements
+
+// The strobe ring moves one pattern repeat per beat between the reading and
+// the note (see main/utils/strobe_phase_engine.hpp), up to
+// TUNER_STROBE_MAX_BEAT_HZ, and keeps moving for up to TUNER_STROBE_MAX_HOLD_MS
+// after the last reading. It's redrawn every TUNER_STROBE_FRAME_MS.
+#define TUNER_STROBE_MAX_BEAT_HZ                5.0f
+#define TUNER_STROBE_MAX_HOLD_MS                250
+#define TUNER_STROBE_FRAME_MS                   33
+
 #define GEAR_SYMBOL "\xEF\x80\x93"
 
 //
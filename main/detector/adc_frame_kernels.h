@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Kernels that turn a frame from the ADC driver into detector-ready samples.
+ *
+ * On ESP32 each continuous-mode result is a 16-bit `adc_digi_output_data_t`
+ * in type1 format: the low 12 bits are the reading and the high 4 bits are
+ * the channel. These kernels read those words directly so the ADC buffer only
+ * has to be walked once: unpacking, removing the DC offset, and tracking the
+ * peak-to-peak range and the sums the noise gate's RMS needs all happen in the
+ * same pass. The per-frame scale (which
+ * needs the whole frame's range) is applied as a multiply when each sample is
+ * handed to the pitch detector.
+ *
+ * These have no ESP-IDF dependencies so tools/pitch-bench can benchmark them.
+ */
+
+#if !defined(TUNER_ADC_FRAME_KERNELS)
+#define TUNER_ADC_FRAME_KERNELS
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#define ADC_TYPE1_DATA_MASK     0x0FFF
+#define ADC_TYPE1_MID_VALUE     2048    // Center of the 12-bit range
+
+/// @brief Min and max of a frame in ADC counts, offset by ADC_TYPE1_MID_VALUE,
+/// and the sums for its RMS.
+typedef struct {
+    int32_t minValue;
+    int32_t maxValue;
+    size_t  count;
+    int32_t sum;            // Fits for frames of up to 1M samples
+    int64_t sumOfSquares;
+} AdcFrameRange;
+
+/// @brief Unpack type1 words into DC-offset int16 samples and track the range
+/// and sums.
+///
+/// Samples are written as `reading - ADC_TYPE1_MID_VALUE` so they fit in
+/// 12 signed bits and float conversion can wait until the detector.
+///
+/// @param words The ADC driver's conversion frame.
+/// @param count Number of words (not bytes) in `words`.
+/// @param out Receives `count` samples.
+/// @return The min and max sample written to `out` and their sums.
+static inline AdcFrameRange adc_unpack_frame_int16(const uint16_t *words, size_t count, int16_t *out) {
+    int32_t minValue = INT32_MAX;
+    int32_t maxValue = INT32_MIN;
+    int32_t sum = 0;
+    int64_t sumOfSquares = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t value = (int32_t)(words[i] & ADC_TYPE1_DATA_MASK) - ADC_TYPE1_MID_VALUE;
+        out[i] = (int16_t)value;
+        minValue = value < minValue ? value : minValue;
+        maxValue = value > maxValue ? value : maxValue;
+        sum += value;
+        sumOfSquares += value * value;
+    }
+    AdcFrameRange range = { minValue, maxValue, count, sum, sumOfSquares };
+    return range;
+}
+
+/// @brief Unpack type1 words into DC-offset float samples and track the range
+/// and sums.
+///
+/// Same as `adc_unpack_frame_int16()` but writes floats.
+static inline AdcFrameRange adc_unpack_frame_float(const uint16_t *words, size_t count, float *out) {
+    int32_t minValue = INT32_MAX;
+    int32_t maxValue = INT32_MIN;
+    int32_t sum = 0;
+    int64_t sumOfSquares = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t value = (int32_t)(words[i] & ADC_TYPE1_DATA_MASK) - ADC_TYPE1_MID_VALUE;
+        out[i] = (float)value;
+        minValue = value < minValue ? value : minValue;
+        maxValue = value > maxValue ? value : maxValue;
+        sum += value;
+        sumOfSquares += value * value;
+    }
+    AdcFrameRange range = { minValue, maxValue, count, sum, sumOfSquares };
+    return range;
+}
+
+/// @brief Peak-to-peak range of a frame in ADC counts.
+static inline int32_t adc_frame_range_peak_to_peak(AdcFrameRange range) {
+    return range.maxValue - range.minValue;
+}
+
+/// @brief RMS of a frame around the frame's own mean, from the sums the
+/// unpack kernels keep.
+///
+/// The mean is taken out so an ADC whose real midpoint isn't exactly
+/// ADC_TYPE1_MID_VALUE doesn't look like signal.
+static inline float adc_frame_range_rms(AdcFrameRange range) {
+    if (range.count == 0) {
+        return 0;
+    }
+    float mean = (float)range.sum / range.count;
+    float meanSquare = (float)range.sumOfSquares / range.count - mean * mean;
+    return meanSquare > 0 ? sqrtf(meanSquare) : 0;
+}
+
+#endif
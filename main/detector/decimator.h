@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Anti-alias low-pass filter and downsampler that sits in front of
+ * q::pitch_detector so it only has to look at every Nth sample.
+ *
+ * The filter is a linear-phase windowed-sinc FIR (Blackman window) that is
+ * only evaluated when an output sample is due, which is the same amount of
+ * work as a polyphase decimator: `tapsPerPhase` multiply-adds per input
+ * sample no matter what the factor is. The history is mirrored like
+ * SampleRing so the taps are always one contiguous run.
+ *
+ * No ESP-IDF dependencies so tools/pitch-bench can use it too.
+ */
+
+#if !defined(TUNER_DECIMATOR)
+#define TUNER_DECIMATOR
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/// @brief Low-pass filters and downsamples by an integer factor.
+class Decimator {
+
+    uint32_t    factor;
+    uint32_t    tapCount;       // factor * tapsPerPhase
+    float       *coefficients = NULL;
+    float       *history = NULL; // 2 * tapCount (mirrored)
+    uint32_t    position = 0;   // Where the next input sample goes
+    uint32_t    phase = 0;      // Input samples since the last output
+
+public:
+
+    /// @param factor Keep one of every `factor` samples. 1 passes samples
+    /// straight through and allocates nothing.
+    /// @param tapsPerPhase Filter length is `factor * tapsPerPhase`. More taps
+    /// make a steeper cutoff.
+    /// @param cutoff Passband edge as a fraction of the output Nyquist
+    /// frequency (0.0 - 1.0). Leaving some room keeps the transition band
+    /// from folding back into the passband.
+    Decimator(uint32_t factor, uint32_t tapsPerPhase, float cutoff) :
+        factor(factor > 0 ? factor : 1), tapCount(this->factor * tapsPerPhase) {
+        if (this->factor == 1 || tapCount == 0) {
+            this->factor = 1;
+            return;
+        }
+
+        // Windowed sinc with unity gain at DC
+        coefficients = new float[tapCount];
+        history = new float[2 * tapCount];
+        double normalizedCutoff = 0.5 * cutoff / this->factor; // Cycles per input sample
+        double center = (tapCount - 1) / 2.0;
+        double sum = 0;
+        for (uint32_t i = 0; i < tapCount; i++) {
+            double x = i - center;
+            double sinc = x == 0 ? 2 * normalizedCutoff : sin(2 * M_PI * normalizedCutoff * x) / (M_PI * x);
+            double window = 0.42 - 0.5 * cos(2 * M_PI * i / (tapCount - 1)) + 0.08 * cos(4 * M_PI * i / (tapCount - 1));
+            coefficients[i] = (float)(sinc * window);
+            sum += coefficients[i];
+        }
+        for (uint32_t i = 0; i < tapCount; i++) {
+            coefficients[i] = (float)(coefficients[i] / sum);
+        }
+        reset();
+    }
+
+    ~Decimator() {
+        delete[] coefficients;
+        delete[] history;
+    }
+
+    Decimator(const Decimator &) = delete;
+    Decimator &operator=(const Decimator &) = delete;
+
+    /// @brief Feed one input sample.
+    /// @param in The input sample.
+    /// @param out Receives the filtered output sample when one is due.
+    /// @return Returns `true` once every `factor` samples, when `out` was set.
+    inline bool push(float in, float *out) {
+        if (factor == 1) {
+            *out = in;
+            return true;
+        }
+
+        history[position] = in;
+        history[position + tapCount] = in;
+        position = position + 1 == tapCount ? 0 : position + 1;
+        if (++phase < factor) {
+            return false;
+        }
+        phase = 0;
+
+        // history[position] is now the oldest sample. The filter is symmetric
+        // so it doesn't matter which end the taps start from.
+        const float *taps = &history[position];
+        float sum = 0;
+        for (uint32_t i = 0; i < tapCount; i++) {
+            sum += coefficients[i] * taps[i];
+        }
+        *out = sum;
+        return true;
+    }
+
+    /// @brief Clear the filter history (after a gap in the signal).
+    void reset() {
+        if (history != NULL) {
+            memset(history, 0, 2 * tapCount * sizeof(float));
+        }
+        position = 0;
+        phase = 0;
+    }
+
+    uint32_t getFactor() const { return factor; }
+
+    /// @brief How far (in input samples) the filter delays the signal.
+    /// PitchPipeline takes this off of its readings' sample indexes and times.
+    uint32_t getDelaySamples() const { return factor == 1 ? 0 : (tapCount - 1) / 2; }
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "detector_profiles.h"
+
+#include "defines.h"
+
+static constexpr DetectorProfile detector_profiles[detectorProfileCount] = {
+    // The ESP32's DMA ADC can't go below 20kHz (SOC_ADC_SAMPLE_FREQ_THRES_LOW),
+    // so this is as low as the CYD goes. Smaller frames keep the latency down
+    // and the detector runs at 10kHz.
+    {
+        .name = "Low Power 20kHz",
+        .sampleRate = 20 * 1000,
+        .frameSamples = 256,
+        .windowSamples = 256,
+        .decimationFactor = 2,
+        .lowestFrequency = 0,
+    },
+    // What the tuner has always used
+    {
+        .name = "Standard 48kHz",
+        .sampleRate = TUNER_ADC_SAMPLE_RATE,
+        .frameSamples = TUNER_ADC_FRAME_SAMPLES,
+        .windowSamples = TUNER_DETECTOR_WINDOW_SAMPLES,
+        .decimationFactor = TUNER_DETECTOR_DECIMATION_FACTOR,
+        .lowestFrequency = 0,
+    },
+    // The detector's default lowest pitch is C1 (32.7Hz), just above the low
+    // B (30.87Hz) of a 5-string bass, so this one goes down to A#0. The
+    // detector only sees the 512 new samples of each frame either way. The
+    // 2048 sample window (85ms, more than two periods of the low B) is only
+    // what the noise gate's RMS and the normalization range are taken over,
+    // so they see whole periods instead of part of one.
+    {
+        .name = "Bass 24kHz",
+        .sampleRate = 24 * 1000,
+        .frameSamples = 512,
+        .windowSamples = 2048,
+        .decimationFactor = TUNER_DETECTOR_DECIMATION_FACTOR,
+        .lowestFrequency = 29.14f,
+    },
+};
+
+/// @brief Every profile's hop (a frame) has to fit in its window, and the
+/// sample ring has to hold a window plus the frame coming in.
+static constexpr bool detector_profiles_fit_sample_ring() {
+    for (const DetectorProfile &profile : detector_profiles) {
+        if (profile.frameSamples == 0
+                || profile.frameSamples > profile.windowSamples
+                || profile.windowSamples + profile.frameSamples > TUNER_SAMPLE_RING_SAMPLES) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(detector_profiles_fit_sample_ring(), "A profile's frame must fit in its window, and a window plus a frame in TUNER_SAMPLE_RING_SAMPLES");
+
+const DetectorProfile *detector_profile_get(uint8_t index) {
+    if (index >= detectorProfileCount) {
+        index = detectorProfileStandard;
+    }
+    return &detector_profiles[index];
+}
+
+PitchPipelineConfig detector_profile_pipeline_config(const DetectorProfile *profile, float sampleClockCorrection) {
+    PitchPipelineConfig config = pitch_pipeline_default_config();
+    config.sampleRate = profile->sampleRate;
+    config.sampleClockCorrection = sampleClockCorrection;
+    config.maxFrameSize = profile->windowSamples;
+    config.decimationFactor = profile->decimationFactor;
+    if (profile->lowestFrequency > 0) {
+        config.lowestFrequency = profile->lowestFrequency;
+    }
+    return config;
+}
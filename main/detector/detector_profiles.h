@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Named sample rate / frame size profiles that can be picked at runtime from
+ * the settings menu. The detector task rebuilds the ADC and the pitch pipeline
+ * when the selected profile changes.
+ *
+ * No ESP-IDF dependencies so tools/pitch-bench can run them too (see its
+ * `--profile` option).
+ */
+
+#if !defined(TUNER_DETECTOR_PROFILES)
+#define TUNER_DETECTOR_PROFILES
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pitch_pipeline.h"
+
+/// @brief The profile IDs. These are saved in NVS so don't reorder them.
+enum DetectorProfileIndex: uint8_t {
+    detectorProfileLowPower = 0,
+    detectorProfileStandard,
+    detectorProfileBass,
+    detectorProfileCount,
+};
+
+/// @brief How the ADC is sampled and how much the detector looks at at once.
+typedef struct {
+    const char  *name;              // Shown in the settings menu
+    uint32_t    sampleRate;         // ADC samples per second
+    uint32_t    frameSamples;       // Samples per ADC conversion frame (also the detector's hop)
+    uint32_t    windowSamples;      // Samples the range check looks at (>= frameSamples)
+    uint32_t    decimationFactor;   // See TUNER_DETECTOR_DECIMATION_FACTOR
+    float       lowestFrequency;    // Lowest pitch (Hz) the detector looks for. 0 uses the pipeline's default (C1).
+} DetectorProfile;
+
+/// @brief Returns the profile for `index` (falls back to the standard profile
+/// if the index is out of range).
+const DetectorProfile *detector_profile_get(uint8_t index);
+
+/// @brief Builds the pitch pipeline config for a profile.
+/// @param sampleClockCorrection The device's correction measured at the
+/// profile's sample rate (see DEFAULT_SAMPLE_CLOCK_CORRECTION).
+PitchPipelineConfig detector_profile_pipeline_config(const DetectorProfile *profile, float sampleClockCorrection);
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Decides whether there's a signal worth sending to the pitch detector.
+ *
+ * A fixed peak-to-peak minimum was either too high for a quiet piezo pickup or
+ * too low for a board with a noisy backlight. Instead, each window's RMS goes
+ * through an envelope follower (instant attack, TUNER_NOISE_GATE_RELEASE_MS
+ * decay) and is compared to a noise floor learned while the gate is closed:
+ *
+ * - Closed: opens once the envelope is TUNER_NOISE_GATE_ONSET_DB over the floor.
+ * - Open: closes once the envelope falls under TUNER_NOISE_GATE_RELEASE_DB over
+ *   the floor. The gap between the two keeps a decaying note from chattering
+ *   on and off the threshold.
+ *
+ * The floor falls faster than it rises so a burst of noise doesn't raise the
+ * bar for long, and it's clamped to TUNER_NOISE_GATE_MIN_FLOOR -
+ * TUNER_NOISE_GATE_MAX_FLOOR.
+ *
+ * No ESP-IDF dependencies so tools/pitch-bench can use it too.
+ */
+
+#if !defined(TUNER_NOISE_GATE)
+#define TUNER_NOISE_GATE
+
+#include <cmath>
+
+#include "defines.h"
+
+class NoiseGate {
+
+    float   envelope = 0;
+    float   noiseFloor = TUNER_NOISE_GATE_INITIAL_FLOOR;
+    bool    isGateOpen = false;
+
+    const float onsetRatio = powf(10.0f, TUNER_NOISE_GATE_ONSET_DB / 20.0f);
+    const float releaseRatio = powf(10.0f, TUNER_NOISE_GATE_RELEASE_DB / 20.0f);
+
+    /// @brief One-pole coefficient for a time constant over `seconds` of audio.
+    static float decay(float seconds, float timeConstantMs) {
+        return expf(-seconds * 1000.0f / timeConstantMs);
+    }
+
+public:
+
+    /// @brief Feed in the next window's level.
+    /// @param rms RMS of the window in ADC counts (see `adc_frame_range_rms()`).
+    /// @param seconds How much new audio the window holds (its hop).
+    /// @return Returns true if the gate is open.
+    bool update(float rms, float seconds) {
+        float release = decay(seconds, TUNER_NOISE_GATE_RELEASE_MS);
+        envelope = rms > envelope ? rms : rms + (envelope - rms) * release;
+
+        if (isGateOpen) {
+            isGateOpen = envelope >= noiseFloor * releaseRatio;
+        } else {
+            isGateOpen = envelope > noiseFloor * onsetRatio;
+        }
+
+        if (!isGateOpen) {
+            // Standby, so whatever is coming in is the noise floor
+            float rate = decay(seconds, rms > noiseFloor ? TUNER_NOISE_GATE_FLOOR_RISE_MS : TUNER_NOISE_GATE_FLOOR_FALL_MS);
+            noiseFloor = rms + (noiseFloor - rms) * rate;
+            noiseFloor = fminf(fmaxf(noiseFloor, TUNER_NOISE_GATE_MIN_FLOOR), TUNER_NOISE_GATE_MAX_FLOOR);
+        }
+        return isGateOpen;
+    }
+
+    bool isOpen() const { return isGateOpen; }
+
+    /// @brief The envelope in ADC counts RMS.
+    float getEnvelope() const { return envelope; }
+
+    /// @brief The learned noise floor in ADC counts RMS.
+    float getNoiseFloor() const { return noiseFloor; }
+
+    /// @brief The envelope level that opens the gate.
+    float getOnsetLevel() const { return noiseFloor * onsetRatio; }
+};
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Checks each q::pitch_detector reading against the recent pitch history
+ * before it gets anywhere near the smoothing filters.
+ *
+ * As a string decays its fundamental fades faster than the harmonics and the
+ * detector can lock onto the 2nd or 3rd harmonic (or, with a weak 2nd
+ * harmonic, an octave below) for a reading or two. Those show up as jumps of
+ * almost exactly an octave, a twelfth, a fifth, and so on from the median of
+ * the last TUNER_OCTAVE_GUARD_HISTORY accepted readings:
+ *
+ * - Harmonic jumps (2x, 3x, 4x and 1/2, 1/3, 1/4) are folded back onto the
+ *   history's pitch.
+ * - Fifth jumps (3/2, 2/3) can't be folded back reliably and are rejected.
+ * - A jump that holds for TUNER_OCTAVE_GUARD_CONFIRM_READINGS readings in a
+ *   row with high periodicity is a real note change and is let through.
+ * - Any other jump of more than TUNER_OCTAVE_GUARD_TOLERANCE_CENTS needs at
+ *   least TUNER_OCTAVE_GUARD_MIN_PERIODICITY.
+ *
+ * All the checks are ratio comparisons against precomputed bounds (no logs),
+ * plus one RunningMedian update, so it's cheap enough to run on every
+ * detected period.
+ *
+ * No ESP-IDF dependencies so tools/pitch-bench can use it too.
+ */
+
+#if !defined(TUNER_OCTAVE_GUARD)
+#define TUNER_OCTAVE_GUARD
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "defines.h"
+#include "reading_filters.hpp"
+
+/// @brief What `OctaveGuard::check()` did with a reading.
+enum OctaveGuardResult: uint8_t {
+    octaveGuardAccepted = 0,    // Passed through unchanged
+    octaveGuardCorrected,       // Folded back onto the history's pitch
+    octaveGuardRejected,        // Must not be used
+};
+
+class OctaveGuard {
+
+    /// @brief A suspicious jump from the history's pitch.
+    typedef struct {
+        float   ratio;          // New frequency / history's frequency
+        bool    isCorrectable;  // Whole-number multiple or fraction
+    } Jump;
+
+    static constexpr size_t jumpCount = 8;
+    static constexpr Jump jumps[jumpCount] = {
+        { 2.0f,         true },
+        { 1.0f / 2,     true },
+        { 3.0f,         true },
+        { 1.0f / 3,     true },
+        { 4.0f,         true },
+        { 1.0f / 4,     true },
+        { 3.0f / 2,     false },
+        { 2.0f / 3,     false },
+    };
+
+    RunningMedian   history;
+    float           tolerance;              // 2^(TUNER_OCTAVE_GUARD_TOLERANCE_CENTS / 1200)
+    int             suspectJump = -1;       // Index in `jumps` of the jump being confirmed
+    uint32_t        suspectCount = 0;
+    uint32_t        correctedCount = 0;
+    uint32_t        rejectedCount = 0;
+
+    bool isNear(float ratio, float target) const {
+        return ratio > target / tolerance && ratio < target * tolerance;
+    }
+
+    /// @brief Starts the history over at a new note.
+    void restartAt(float frequency) {
+        history.reset();
+        history.addValue(frequency);
+        suspectJump = -1;
+        suspectCount = 0;
+    }
+
+public:
+
+    OctaveGuard() : history(TUNER_OCTAVE_GUARD_HISTORY),
+        tolerance(exp2f(TUNER_OCTAVE_GUARD_TOLERANCE_CENTS / 1200.0f)) {}
+
+    /// @brief Check a reading.
+    /// @param frequency The detector's reading. Replaced with the corrected
+    /// frequency when `octaveGuardCorrected` is returned.
+    /// @param periodicity The detector's confidence in the reading (0.0 - 1.0).
+    OctaveGuardResult check(float *frequency, float periodicity) {
+        float f = *frequency;
+
+        if (history.getCount() < TUNER_OCTAVE_GUARD_MIN_HISTORY) {
+            // Not enough to go on yet. Just keep junk out of the history.
+            if (periodicity < TUNER_OCTAVE_GUARD_MIN_PERIODICITY) {
+                rejectedCount++;
+                return octaveGuardRejected;
+            }
+            history.addValue(f);
+            return octaveGuardAccepted;
+        }
+
+        float ratio = f / history.getMedian();
+        if (isNear(ratio, 1.0f)) {
+            suspectJump = -1;
+            suspectCount = 0;
+            history.addValue(f);
+            return octaveGuardAccepted;
+        }
+
+        int jump = -1;
+        for (size_t i = 0; i < jumpCount; i++) {
+            if (isNear(ratio, jumps[i].ratio)) {
+                jump = (int)i;
+                break;
+            }
+        }
+
+        if (jump < 0) {
+            // Not a harmonic, so either a new note or a glitch
+            if (periodicity < TUNER_OCTAVE_GUARD_MIN_PERIODICITY) {
+                rejectedCount++;
+                return octaveGuardRejected;
+            }
+            restartAt(f);
+            return octaveGuardAccepted;
+        }
+
+        if (jump == suspectJump) {
+            suspectCount++;
+        } else {
+            suspectJump = jump;
+            suspectCount = 1;
+        }
+        if (suspectCount >= TUNER_OCTAVE_GUARD_CONFIRM_READINGS && periodicity >= TUNER_OCTAVE_GUARD_CONFIDENT_PERIODICITY) {
+            // It held steady and the detector is sure of it. The player
+            // really did go up or down an octave (or a fifth).
+            restartAt(f);
+            return octaveGuardAccepted;
+        }
+
+        if (!jumps[jump].isCorrectable) {
+            rejectedCount++;
+            return octaveGuardRejected;
+        }
+        f /= jumps[jump].ratio;
+        history.addValue(f);
+        *frequency = f;
+        correctedCount++;
+        return octaveGuardCorrected;
+    }
+
+    /// @brief Forget the history (the next readings start a new note).
+    void reset() {
+        history.reset();
+        suspectJump = -1;
+        suspectCount = 0;
+    }
+
+    /// @brief Readings folded back onto the history's pitch since creation.
+    uint32_t getCorrectedCount() const { return correctedCount; }
+
+    /// @brief Readings rejected since creation.
+    uint32_t getRejectedCount() const { return rejectedCount; }
+};
+
+#endif
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "pitch_pipeline.h"
+
+#include "defines.h"
+
+#include <cmath>
+
+#include <q/support/literals.hpp>
+#include <q/support/pitch_names.hpp>
+
+namespace q = cycfi::q;
+using namespace q::literals;
+
+using frequency = cycfi::q::frequency;
+CONSTEXPR frequency low_fs = cycfi::q::pitch_names::C[1];
+CONSTEXPR frequency high_fs = cycfi::q::pitch_names::C[7]; // Setting this higher helps to catch the high harmonics
+
+// q::one_pole_lowpass         lp{high_fs, TUNER_ADC_SAMPLE_RATE};
+// q::one_pole_lowpass         lp2(low_fs, TUNER_ADC_SAMPLE_RATE);
+
+// constexpr float             slope = 1.0f/2;
+// constexpr float             makeup_gain = 2;
+// q::compressor               comp{ -18_dB, slope };
+// q::clip                     clip;
+
+// auto sc_conf = q::signal_conditioner::config{};
+// auto sig_cond = q::signal_conditioner{sc_conf, low_fs, high_fs, TUNER_ADC_SAMPLE_RATE};
+
+PitchPipelineConfig pitch_pipeline_default_config() {
+    PitchPipelineConfig config = {
+        .sampleRate = TUNER_ADC_SAMPLE_RATE,
+        .sampleClockCorrection = DEFAULT_SAMPLE_CLOCK_CORRECTION,
+        .maxFrameSize = TUNER_DETECTOR_WINDOW_SAMPLES,
+        .decimationFactor = TUNER_DETECTOR_DECIMATION_FACTOR,
+        .relockHoldMs = TUNER_RELOCK_HOLD_MS,
+        .lowestFrequency = as_float(low_fs),
+    };
+    return config;
+}
+
+PitchPipeline::PitchPipeline(const PitchPipelineConfig &config) :
+    config(config),
+    sampleRate(config.sampleRate * config.sampleClockCorrection),
+    decimator(config.decimationFactor, TUNER_DECIMATOR_TAPS_PER_PHASE, TUNER_DECIMATOR_CUTOFF),
+    pd(frequency(config.lowestFrequency), high_fs, sampleRate / decimator.getFactor(), -40_dB),
+    chain(std::in_place_type<OneEuroFirstChain>, sampleRate, reading_chain_default_settings()),
+    clock(sampleRate),
+    holdSamples((uint64_t)(config.relockHoldMs * sampleRate / 1000.0f)),
+    relockTolerance(exp2f(TUNER_RELOCK_TOLERANCE_CENTS / 1200.0f)) {
+    configureChain(reading_chain_default_settings());
+    windowSamples = new int16_t[config.maxFrameSize];
+}
+
+PitchPipeline::~PitchPipeline() {
+    delete[] windowSamples;
+}
+
+void PitchPipeline::configureChain(const ReadingChainSettings &settings) {
+    // Built in place, so this doesn't allocate
+    if (settings.use1EUFilterFirst) {
+        chain.emplace<OneEuroFirstChain>(sampleRate, settings);
+    } else {
+        chain.emplace<SmoothingFirstChain>(sampleRate, settings);
+    }
+}
+
+const OctaveGuard &PitchPipeline::getOctaveGuard() {
+    return std::visit([](auto &c) -> const OctaveGuard & { return c.template get<OctaveGuardStage>().guard; }, chain);
+}
+
+size_t PitchPipeline::getChainStats(const ReadingStageStats **stats) {
+    return std::visit([stats](auto &c) {
+        *stats = c.getStats();
+        return c.stageCount;
+    }, chain);
+}
+
+PitchFrameResult PitchPipeline::processFrame(const uint16_t *adcWords, size_t count, int64_t timeUs, pitch_pipeline_reading_cb_t readingCallback, void *userData) {
+    return processWindow(adcWords, count, count, timeUs, readingCallback, userData);
+}
+
+PitchFrameResult PitchPipeline::processWindow(const uint16_t *adcWords, size_t windowSize, size_t hop, int64_t timeUs, pitch_pipeline_reading_cb_t readingCallback, void *userData) {
+    // Unpack the ADC words and track the min and max values (and the RMS sums
+    // for the noise gate) in one pass so we can convert to values between
+    // -1.0f and +1.0f
+    clock.anchor(samplesProcessed, timeUs);
+    AdcFrameRange frameRange = adc_unpack_frame_int16(adcWords, windowSize, windowSamples);
+
+    // Bail out while there's nothing but noise. When the gate closes, the
+    // detector keeps running (without publishing) and nothing is reset until
+    // the hold runs out, so a string plucked again right away doesn't have to
+    // be found all over again.
+    bool wasGateOpen = noiseGate.isOpen();
+    bool isGateOpen = noiseGate.update(adc_frame_range_rms(frameRange), hop / sampleRate);
+    if (isGateOpen && !wasGateOpen) {
+        isAwaitingFirstReading = true;
+        isRelockOnset = isHolding;
+        isCheckingRelock = isHolding;
+        relockCandidate = 0;
+        onsetSample = samplesProcessed;
+        isHolding = false;
+    } else if (!isGateOpen && wasGateOpen) {
+        isAwaitingFirstReading = false;
+        isCheckingRelock = false;
+        isHolding = true;
+        holdEndSample = samplesProcessed + holdSamples;
+    }
+    if (!isGateOpen && (!isHolding || samplesProcessed >= holdEndSample)) {
+        samplesProcessed += hop;
+        if (isHolding) {
+            isHolding = false;
+            reset(); // So the next frequency detected will be as fast as possible
+        }
+        return pitchFrameNoSignal;
+    }
+    float range = (float)adc_frame_range_peak_to_peak(frameRange);
+
+    // Normalize the values between -1.0 and +1.0 as they're handed to qlib
+    // (in the number format picked by TUNER_NUMERIC_POLICY). During the gate's
+    // release and the hold a window can be flat or nearly so, and stretching
+    // that to full scale would hand the detector nothing but amplified noise,
+    // so it gets silence instead (and keeps its timing).
+    NumericPolicy::Normalizer normalizer = range < TUNER_DETECTOR_MIN_PEAK_TO_PEAK
+        ? NumericPolicy::normalizer(frameRange.minValue, frameRange.minValue)
+        : NumericPolicy::normalizer(frameRange.minValue, frameRange.maxValue);
+    float amplitude = range / ADC_TYPE1_DATA_MASK;
+
+    // Only the samples at the end of the window are new to the detector
+    for (size_t i = windowSize - hop; i < windowSize; i++, samplesProcessed++) {
+        float s = NumericPolicy::toDetector(NumericPolicy::normalize(normalizer, windowSamples[i])); // input signal
+
+        // I've got the signal conditioning commented out right now
+        // because it actually is making the frequency readings
+        // NOT work. They probably just need to be tweaked a little.
+
+        // Signal Conditioner
+        // s = sig_cond(s);
+
+        // // Bandpass filter
+        // s = lp(s);
+        // s -= lp2(s);
+
+        // // Compressor + make-up gain + hard clip (the envelope and gate
+        // // are in noise_gate.h now)
+        // auto gain = cycfi::q::lin_float(comp(q::lin_to_db(noiseGate.getEnvelope()))) * makeup_gain;
+        // s = clip(s * gain);
+
+        // Anti-alias and downsample. The detector only sees every
+        // `decimationFactor`th sample (its clock still counts input samples).
+        if (!decimator.push(s, &s)) {
+            continue;
+        }
+
+        // Pitch Detect
+        // Send in each value into the pitch detector
+        if (pd(s) == true) { // calculated a frequency
+            if (isHolding) {
+                continue; // Only keeping the detector going
+            }
+            if (isCheckingRelock) {
+                // The first period after a re-pluck spans the quiet gap, so
+                // wait for two readings that agree.
+                float f = pd.get_frequency();
+                bool isSteady = relockCandidate > 0 && isWithinRelockTolerance(f, relockCandidate);
+                relockCandidate = f;
+                if (!isSteady) {
+                    continue;
+                }
+                // The filters only help if it's the same note again. A
+                // different one (or the last note's noisy tail) would be
+                // dragged toward the old pitch, so start them over.
+                if (!isWithinRelockTolerance(f, lastChainFrequency)) {
+                    std::visit([](auto &c) { c.reset(); }, chain);
+                }
+                isCheckingRelock = false;
+            }
+            float rawFrequency = pd.get_frequency();
+
+            // The anti-alias filter delays what the detector sees, so the
+            // reading describes the signal from that many samples back
+            uint64_t delay = decimator.getDelaySamples();
+            uint64_t readingSample = samplesProcessed > delay ? samplesProcessed - delay : 0;
+
+            // Octave guard, reading filter, 1EU, and exponential smoothing.
+            // Readings the guard drops are never published.
+            ChainReading chainReading = {
+                .frequency = pd.get_frequency(),
+                .periodicity = pd.periodicity(),
+                .sampleIndex = readingSample,
+            };
+            bool isKept = std::visit([&chainReading](auto &c) { return c.run(&chainReading); }, chain);
+            if (!isKept) {
+                continue;
+            }
+            lastChainFrequency = chainReading.frequency;
+
+            PitchReading reading = {
+                .frequency = chainReading.frequency,
+                .rawFrequency = rawFrequency,
+                .periodicity = pd.periodicity(),
+                .amplitude = amplitude,
+                .sampleIndex = readingSample,
+                .timeUs = clock.timeUs(readingSample),
+            };
+            if (isAwaitingFirstReading) {
+                recordFirstReading(samplesProcessed);
+            }
+            readingCallback(&reading, userData);
+        }
+    }
+
+    return isHolding ? pitchFrameHolding : pitchFrameProcessed;
+}
+
+bool PitchPipeline::isWithinRelockTolerance(float frequency, float reference) {
+    float ratio = frequency / reference;
+    return ratio > 1.0f / relockTolerance && ratio < relockTolerance;
+}
+
+void PitchPipeline::recordFirstReading(uint64_t sampleIndex) {
+    isAwaitingFirstReading = false;
+    uint64_t samples = sampleIndex - onsetSample;
+    if (isRelockOnset) {
+        onsetStats.relockOnsets++;
+        onsetStats.relockSamples += samples;
+    } else {
+        onsetStats.coldOnsets++;
+        onsetStats.coldSamples += samples;
+    }
+    onsetStats.maxSamples = samples > onsetStats.maxSamples ? samples : onsetStats.maxSamples;
+}
+
+void PitchPipeline::reset() {
+    std::visit([](auto &c) { c.reset(); }, chain);
+    pd.reset();
+    decimator.reset();
+    isHolding = false;
+}
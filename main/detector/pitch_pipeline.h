@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * The pitch pipeline is the ADC-independent part of the pitch detector. It
+ * takes frames straight from the ADC driver's buffer (type1 16-bit words) and
+ * turns them into frequency readings.
+ *
+ * IMPORTANT: Nothing in here may depend on ESP-IDF or FreeRTOS. This same code
+ * is compiled on Linux by tools/pitch-bench so that changes to smoothing and
+ * thresholds can be measured against recorded guitar and bass WAV files.
+ */
+
+#if !defined(TUNER_PITCH_PIPELINE)
+#define TUNER_PITCH_PIPELINE
+
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+
+#include <q/pitch/pitch_detector.hpp>
+
+#include "adc_frame_kernels.h"
+#include "decimator.h"
+#include "noise_gate.h"
+#include "numeric_policy.hpp"
+#include "reading_chain.h"
+#include "sample_clock.h"
+
+/// @brief Parameters used to build a pitch pipeline.
+typedef struct {
+    float   sampleRate;         // Samples per second the ADC was asked for
+    float   sampleClockCorrection; // The ADC's real sample rate / `sampleRate` (see DEFAULT_SAMPLE_CLOCK_CORRECTION)
+    size_t  maxFrameSize;       // Largest frame (or window) that will be passed to `processFrame()` or `processWindow()`
+    uint32_t decimationFactor;  // Only every Nth (anti-aliased) sample goes to the detector. 1 means off.
+    float   relockHoldMs;       // How long the detector and filters keep their state after the noise gate closes
+    float   lowestFrequency;    // Lowest pitch (Hz) the detector looks for
+} PitchPipelineConfig;
+
+/// @brief Returns the config that matches how the firmware runs on the CYD.
+PitchPipelineConfig pitch_pipeline_default_config();
+
+/// @brief A single frequency produced by the pipeline.
+typedef struct {
+    float       frequency;      // The filtered frequency (in Hz)
+    float       rawFrequency;   // What q::pitch_detector reported, before filtering
+    float       periodicity;    // The detector's confidence (0.0 - 1.0)
+    float       amplitude;      // Peak-to-peak of the frame as a fraction of the ADC's full range
+    uint64_t    sampleIndex;    // Index of the sample (counted from when the pipeline was created) that completed the reading, less the decimator's delay
+    int64_t     timeUs;         // Capture time of that sample in microseconds (see `SampleClock`)
+} PitchReading;
+
+/// @brief Called for every frequency the pipeline produces.
+/// @param reading The reading. Only valid during the callback.
+/// @param userData The `userData` passed to `PitchPipeline::processFrame()`.
+typedef void (*pitch_pipeline_reading_cb_t)(const PitchReading *reading, void *userData);
+
+/// @brief The result of processing a single frame of samples.
+enum PitchFrameResult: uint8_t {
+    pitchFrameProcessed = 0,    // The frame had enough signal and was sent through the detector
+    pitchFrameNoSignal,         // The noise gate is closed and the hold is over (the pipeline was reset)
+    pitchFrameHolding,          // The noise gate is closed but the detector is kept running for a re-pluck. Nothing is published.
+};
+
+/// @brief How long it takes to publish the first reading after the noise gate opens.
+typedef struct {
+    uint32_t    coldOnsets;         // Onsets after the pipeline was reset
+    uint64_t    coldSamples;        // Total samples from those onsets to their first reading
+    uint32_t    relockOnsets;       // Onsets during the hold (the detector and filters kept their state)
+    uint64_t    relockSamples;
+    uint64_t    maxSamples;         // Longest of either
+} PitchOnsetStats;
+
+/// @brief Noise gate, normalization, decimation, pitch detection, and the reading chain.
+class PitchPipeline {
+
+    PitchPipelineConfig config;
+    float               sampleRate; // What the ADC really runs at (`sampleRate` x `sampleClockCorrection`)
+
+    NoiseGate                   noiseGate;
+    Decimator                   decimator;
+    cycfi::q::pitch_detector    pd;
+
+    // Everything after the detector (see reading_chain.h). Which type is held
+    // depends on ReadingChainSettings::use1EUFilterFirst.
+    std::variant<OneEuroFirstChain, SmoothingFirstChain> chain;
+
+    uint64_t samplesProcessed = 0;
+    SampleClock clock;
+
+    // Re-lock hold (see TUNER_RELOCK_HOLD_MS)
+    uint64_t holdSamples;
+    bool     isHolding = false;
+    uint64_t holdEndSample = 0;
+    float    relockTolerance;           // 2^(TUNER_RELOCK_TOLERANCE_CENTS / 1200)
+    float    lastChainFrequency = 0;    // The chain's last output
+    bool     isCheckingRelock = false;
+    float    relockCandidate = 0;       // First reading after a re-lock, waiting for the next to agree
+
+    // Onset to first reading
+    bool     isAwaitingFirstReading = false;
+    bool     isRelockOnset = false;
+    uint64_t onsetSample = 0;
+    PitchOnsetStats onsetStats = {};
+
+    bool isWithinRelockTolerance(float frequency, float reference);
+    void recordFirstReading(uint64_t sampleIndex);
+
+    // What each window's ADC readings are unpacked into (`maxFrameSize`
+    // samples). Allocated once in the constructor and reused for every window
+    // so the steady-state sample path never touches the heap. A window is
+    // finished with before the next one is unpacked, so one is enough.
+    int16_t *windowSamples;
+
+public:
+
+    PitchPipeline(const PitchPipelineConfig &config);
+    ~PitchPipeline();
+
+    PitchPipeline(const PitchPipeline &) = delete;
+    PitchPipeline &operator=(const PitchPipeline &) = delete;
+
+    /// @brief Rebuild the reading chain (octave guard, filters, and smoothing)
+    /// from user settings. This starts the filters over, so only call it
+    /// when the settings change.
+    void configureChain(const ReadingChainSettings &settings);
+
+    /// @brief Run one frame from the ADC driver through the pipeline.
+    ///
+    /// `adcWords` holds type1 conversion results (a 12-bit reading in the low
+    /// bits of each word). They are unpacked, DC-offset, and range-checked in a
+    /// single pass by `adc_unpack_frame_int16()` and normalized as they are fed
+    /// to the detector.
+    ///
+    /// @param adcWords The ADC driver's conversion frame. This is not modified.
+    /// @param count Number of words in `adcWords` (at most `maxFrameSize`).
+    /// @param timeUs Time (in microseconds) the first sample in the frame was
+    /// captured. Every other sample's time is derived from this.
+    /// @param readingCallback Called for every detected frequency.
+    /// @param userData Passed back to `readingCallback`.
+    PitchFrameResult processFrame(const uint16_t *adcWords, size_t count, int64_t timeUs, pitch_pipeline_reading_cb_t readingCallback, void *userData);
+
+    /// @brief Run an analysis window that overlaps the previous one.
+    ///
+    /// The noise gate and normalization use the whole window (so a longer
+    /// window can cover a full period of a low bass note) but only the last
+    /// `hop` samples are new and fed to the detector. `processFrame()` is the
+    /// same thing with `hop == count`.
+    ///
+    /// @param adcWords The window of type1 conversion results.
+    /// @param windowSize Number of words in `adcWords` (at most `maxFrameSize`).
+    /// @param hop Number of new samples at the end of the window.
+    /// @param timeUs Time (in microseconds) the first NEW sample was captured.
+    PitchFrameResult processWindow(const uint16_t *adcWords, size_t windowSize, size_t hop, int64_t timeUs, pitch_pipeline_reading_cb_t readingCallback, void *userData);
+
+    /// @brief Reset the detector and filters so the next reading is as fast as possible.
+    void reset();
+
+    /// @brief Total number of samples that have gone through the pipeline.
+    uint64_t getSamplesProcessed() { return samplesProcessed; }
+
+    /// @brief The clock used to timestamp samples.
+    const SampleClock &getClock() { return clock; }
+
+    const PitchPipelineConfig &getConfig() { return config; }
+
+    /// @brief The gate's envelope and learned noise floor.
+    const NoiseGate &getNoiseGate() { return noiseGate; }
+
+    /// @brief Time to the first reading after each onset since the pipeline was created.
+    const PitchOnsetStats &getOnsetStats() { return onsetStats; }
+
+    /// @brief Counts of the readings the octave guard has corrected and rejected.
+    const OctaveGuard &getOctaveGuard();
+
+    /// @brief Time spent in each stage of the reading chain since it was built.
+    /// @param stats Set to the chain's stats, in chain order.
+    /// @return The number of stages.
+    size_t getChainStats(const ReadingStageStats **stats);
+};
+
+#endif
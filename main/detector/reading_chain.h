@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * The stages every detector reading goes through before it's published:
+ * octave guard, reading filter, 1EU filter, and exponential smoothing.
+ *
+ * A chain is a `std::tuple` of stages, so the order is fixed at compile time
+ * and each stage call is a direct (inlinable) call. The two orders the
+ * "1 EU 1st?" setting picks between are two chain types. PitchPipeline holds
+ * one of them in a `std::variant` and builds it once from
+ * `ReadingChainSettings`, then again only when the settings change.
+ *
+ * Every stage has a counter of the cycles spent in it (nanoseconds on the
+ * host, see cycle_counter.h).
+ *
+ * Note debouncing isn't in here. It works on note names at display time,
+ * see utils/note_debouncer.hpp.
+ *
+ * No ESP-IDF dependencies (other than the cycle counter) so tools/pitch-bench
+ * can use it too.
+ */
+
+#if !defined(TUNER_READING_CHAIN)
+#define TUNER_READING_CHAIN
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+#include "cached_one_euro_filter.hpp"
+#include "cycle_counter.h"
+#include "defines.h"
+#include "exponential_smoother.hpp"
+#include "numeric_policy.hpp"
+#include "octave_guard.h"
+#include "reading_filters.hpp"
+
+/// @brief User settings the chain is built from.
+typedef struct {
+    bool    use1EUFilterFirst;  // 1EU then exponential smoothing (or the other way around)
+    float   expSmoothing;
+    float   oneEUBeta;
+    uint8_t readingFilterType;  // A ReadingFilterType
+    uint8_t readingFilterWindow;
+    bool    useOctaveGuard;
+} ReadingChainSettings;
+
+/// @brief Returns the settings that match the defaults in defines.h.
+static inline ReadingChainSettings reading_chain_default_settings() {
+    ReadingChainSettings settings = {
+        .use1EUFilterFirst = DEFAULT_USE_1EU_FILTER_FIRST,
+        .expSmoothing = DEFAULT_EXP_SMOOTHING,
+        .oneEUBeta = DEFAULT_ONE_EU_BETA,
+        .readingFilterType = DEFAULT_READING_FILTER_TYPE,
+        .readingFilterWindow = (uint8_t)DEFAULT_READING_FILTER_WINDOW,
+        .useOctaveGuard = TUNER_OCTAVE_GUARD_ENABLED,
+    };
+    return settings;
+}
+
+/// @brief A reading on its way through the chain.
+typedef struct {
+    float       frequency;      // Hz
+    float       periodicity;    // The detector's confidence (0.0 - 1.0)
+    uint64_t    sampleIndex;    // Input sample index the reading was taken at
+} ChainReading;
+
+/// @brief Time spent in one stage since the chain was built.
+typedef struct {
+    const char  *name;
+    uint64_t    cycles;         // TUNER_CYCLE_COUNT_UNITS
+    uint32_t    readings;       // Readings that reached the stage
+} ReadingStageStats;
+
+//
+// Stages. Each one is built from the sample rate and the settings, and
+// `process()` returns false to drop the reading (later stages don't see it).
+//
+
+struct OctaveGuardStage {
+    static constexpr const char *name = "octave guard";
+    OctaveGuard guard;
+    bool        isEnabled;
+
+    OctaveGuardStage(float, const ReadingChainSettings &settings) : isEnabled(settings.useOctaveGuard) {}
+    inline bool process(ChainReading *reading) {
+        return !isEnabled || guard.check(&reading->frequency, reading->periodicity) != octaveGuardRejected;
+    }
+    void reset() { guard.reset(); }
+};
+
+struct ReadingFilterStage {
+    static constexpr const char *name = "reading filter";
+    ReadingFilter filter;
+
+    ReadingFilterStage(float, const ReadingChainSettings &settings) :
+        filter(settings.readingFilterType, settings.readingFilterWindow) {}
+    inline bool process(ChainReading *reading) {
+        reading->frequency = filter.filter(reading->frequency);
+        return true;
+    }
+    void reset() { filter.reset(); }
+};
+
+struct OneEuroStage {
+    static constexpr const char *name = "1EU filter";
+    CachedOneEuroFilter<NumericPolicy::value_t> filter;
+
+    // Timed by input sample (before decimation)
+    OneEuroStage(float sampleRate, const ReadingChainSettings &settings) :
+        filter(sampleRate, EU_FILTER_MIN_CUTOFF, settings.oneEUBeta, EU_FILTER_DERIVATIVE_CUTOFF) {}
+    inline bool process(ChainReading *reading) {
+        reading->frequency = NumericPolicy::toHz(filter.filter(NumericPolicy::fromHz(reading->frequency), reading->sampleIndex));
+        return true;
+    }
+    void reset() { filter.reset(); }
+};
+
+struct SmoothingStage {
+    static constexpr const char *name = "exp smoothing";
+    ExponentialSmoother smoother;
+
+    SmoothingStage(float, const ReadingChainSettings &settings) : smoother(settings.expSmoothing) {}
+    inline bool process(ChainReading *reading) {
+        reading->frequency = smoother.smooth(reading->frequency);
+        return true;
+    }
+    void reset() { smoother.reset(); }
+};
+
+/// @brief Runs each of `Stages` in order.
+template <typename... Stages>
+class ReadingChain {
+
+    std::tuple<Stages...>   stages;
+    ReadingStageStats       stats[sizeof...(Stages)] = { { Stages::name, 0, 0 }... };
+
+    template <size_t I>
+    inline bool runFrom(ChainReading *reading) {
+        if constexpr (I == sizeof...(Stages)) {
+            return true;
+        } else {
+            uint32_t start = tuner_cycle_count();
+            bool isKept = std::get<I>(stages).process(reading);
+            stats[I].cycles += tuner_cycle_count() - start;
+            stats[I].readings++;
+            return isKept && runFrom<I + 1>(reading);
+        }
+    }
+
+public:
+
+    static constexpr size_t stageCount = sizeof...(Stages);
+
+    ReadingChain(float sampleRate, const ReadingChainSettings &settings) :
+        stages(Stages(sampleRate, settings)...) {}
+
+    /// @brief Run a reading through every stage.
+    /// @return Returns false if a stage dropped it.
+    inline bool run(ChainReading *reading) { return runFrom<0>(reading); }
+
+    void reset() {
+        std::apply([](auto &... stage) { (stage.reset(), ...); }, stages);
+    }
+
+    template <typename Stage>
+    const Stage &get() const { return std::get<Stage>(stages); }
+
+    /// @brief `stageCount` entries, in chain order.
+    const ReadingStageStats *getStats() const { return stats; }
+};
+
+typedef ReadingChain<OctaveGuardStage, ReadingFilterStage, OneEuroStage, SmoothingStage> OneEuroFirstChain;
+typedef ReadingChain<OctaveGuardStage, ReadingFilterStage, SmoothingStage, OneEuroStage> SmoothingFirstChain;
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Per-sample timestamps for the pitch pipeline.
+ *
+ * The clock is anchored once per frame (one `esp_timer_get_time()` call in
+ * the detector task) and any sample's capture time is derived from how many
+ * samples it is past the anchor. Nothing is computed per sample. A timestamp
+ * costs one multiply and is only worked out when something actually needs it,
+ * like when the detector produces a reading.
+ *
+ * No ESP-IDF dependencies so tools/pitch-bench can use it too.
+ */
+
+#if !defined(TUNER_SAMPLE_CLOCK)
+#define TUNER_SAMPLE_CLOCK
+
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Converts absolute sample indices into capture times.
+class SampleClock {
+
+    double      microsPerSample;
+    int64_t     anchorTimeUs = 0;
+    uint64_t    anchorSampleIndex = 0;
+
+public:
+
+    SampleClock(float sampleRate) { setSampleRate(sampleRate); }
+
+    void setSampleRate(float sampleRate) { microsPerSample = 1000000.0 / sampleRate; }
+
+    /// @brief Record that `sampleIndex` was captured at `timeUs`.
+    ///
+    /// Call this once per frame with the first sample of the frame. Samples
+    /// before the anchor get times before `timeUs`.
+    void anchor(uint64_t sampleIndex, int64_t timeUs) {
+        anchorSampleIndex = sampleIndex;
+        anchorTimeUs = timeUs;
+    }
+
+    /// @brief Capture time of `sampleIndex` in microseconds.
+    int64_t timeUs(uint64_t sampleIndex) const {
+        return anchorTimeUs + (int64_t)(((int64_t)(sampleIndex - anchorSampleIndex)) * microsPerSample);
+    }
+
+    /// @brief How long `sampleCount` samples take to capture, in microseconds.
+    int64_t durationUs(size_t sampleCount) const {
+        return (int64_t)(sampleCount * microsPerSample);
+    }
+};
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * A single-producer/single-consumer ring of raw ADC words that sits between
+ * the ADC conversion-done ISR and the pitch detector task.
+ *
+ * Every sample is written twice, at `i` and `i + capacity`. That way any
+ * window of up to `capacity` samples starting at the read position is
+ * contiguous in memory. The detector can look at long or overlapping windows
+ * with `peek()` and then advance by a smaller hop with `consume()`, all
+ * without copying.
+ *
+ * Counts are 32-bit (atomic on the ESP32) and wrap, so the capacity must be
+ * a power of two.
+ *
+ * No ESP-IDF dependencies so tools/pitch-bench can use it too.
+ */
+
+#if !defined(TUNER_SAMPLE_RING)
+#define TUNER_SAMPLE_RING
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class SampleRing {
+
+    uint16_t    *buffer;    // 2 * capacity words (mirrored)
+    uint32_t    capacity;
+    uint32_t    mask;
+
+    std::atomic<uint32_t> writeCount{0};    // Only changed by the producer
+    std::atomic<uint32_t> readCount{0};     // Only changed by the consumer
+    std::atomic<uint32_t> overrunCount{0};  // Blocks the producer had to drop
+    std::atomic<uint32_t> fillMaximum{0};   // High-water mark of `available()`
+
+public:
+
+    /// @param capacity Number of samples the ring holds. Must be a power of two.
+    SampleRing(uint32_t capacity) : capacity(capacity), mask(capacity - 1) {
+        buffer = new uint16_t[2 * capacity];
+    }
+
+    ~SampleRing() {
+        delete[] buffer;
+    }
+
+    SampleRing(const SampleRing &) = delete;
+    SampleRing &operator=(const SampleRing &) = delete;
+
+    /// @brief Producer side (the ADC ISR). Appends a block of samples.
+    ///
+    /// If the whole block doesn't fit, it is dropped and counted as an overrun.
+    /// Data the consumer has peeked at is never overwritten.
+    ///
+    /// @return Returns `false` if the block was dropped.
+    bool write(const uint16_t *words, uint32_t count) {
+        uint32_t written = writeCount.load(std::memory_order_relaxed);
+        uint32_t read = readCount.load(std::memory_order_acquire);
+        uint32_t used = written - read;
+        if (count > capacity - used) {
+            overrunCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint32_t position = written & mask;
+        uint32_t firstPart = capacity - position;
+        if (firstPart > count) {
+            firstPart = count;
+        }
+        // Lower copy
+        memcpy(&buffer[position], words, firstPart * sizeof(uint16_t));
+        memcpy(&buffer[0], words + firstPart, (count - firstPart) * sizeof(uint16_t));
+        // Mirror copy
+        memcpy(&buffer[position + capacity], words, firstPart * sizeof(uint16_t));
+        memcpy(&buffer[capacity], words + firstPart, (count - firstPart) * sizeof(uint16_t));
+
+        writeCount.store(written + count, std::memory_order_release);
+
+        used += count;
+        if (used > fillMaximum.load(std::memory_order_relaxed)) {
+            fillMaximum.store(used, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /// @brief Consumer side. Returns `window` contiguous samples starting at
+    /// the read position, or NULL if fewer than that are available.
+    ///
+    /// The pointer stays valid until `consume()` moves past it.
+    const uint16_t *peek(uint32_t window) const {
+        uint32_t read = readCount.load(std::memory_order_relaxed);
+        uint32_t written = writeCount.load(std::memory_order_acquire);
+        if (window > capacity || written - read < window) {
+            return NULL;
+        }
+        return &buffer[read & mask];
+    }
+
+    /// @brief Consumer side. Advances the read position by `hop` samples.
+    void consume(uint32_t hop) {
+        uint32_t read = readCount.load(std::memory_order_relaxed);
+        uint32_t available = writeCount.load(std::memory_order_acquire) - read;
+        if (hop > available) {
+            hop = available;
+        }
+        readCount.store(read + hop, std::memory_order_release);
+    }
+
+    /// @brief Number of samples waiting to be consumed (the fill level).
+    uint32_t available() const {
+        return writeCount.load(std::memory_order_acquire) - readCount.load(std::memory_order_acquire);
+    }
+
+    /// @brief Total samples consumed. Wraps at 2^32.
+    uint32_t getReadCount() const { return readCount.load(std::memory_order_relaxed); }
+
+    /// @brief Total samples written. Wraps at 2^32.
+    uint32_t getWriteCount() const { return writeCount.load(std::memory_order_acquire); }
+
+    /// @brief Number of blocks dropped because the ring was full.
+    uint32_t getOverrunCount() const { return overrunCount.load(std::memory_order_relaxed); }
+
+    /// @brief The most samples that have been waiting at once.
+    uint32_t getFillMaximum() const { return fillMaximum.load(std::memory_order_relaxed); }
+
+    uint32_t getCapacity() const { return capacity; }
+};
+
+#endif
@@ -18,21 +18,28 @@
  */
 #include "globals.h"
 
-#include "freertos/FreeRTOS.h"
+#include "seq_lock.hpp"
 
-float current_frequency = -1.0f;
-portMUX_TYPE current_frequency_mutex = portMUX_INITIALIZER_UNLOCKED;
+// The detector (core 1) is the only writer and the GUI (core 0) reads. A
+// seqlock means neither side takes a spinlock or disables interrupts.
+static const TunerPitchResult initial_pitch_result = {
+    .frequency = -1.0f,
+    .rawFrequency = -1.0f,
+};
+static SeqLock<TunerPitchResult> current_pitch_result(initial_pitch_result);
+static uint32_t pitch_result_sequence = 0; // Only touched by the writer
 
-float get_current_frequency() {
-    float frequency = -1.0f;
-    portENTER_CRITICAL(&current_frequency_mutex);
-    frequency = current_frequency;
-    portEXIT_CRITICAL(&current_frequency_mutex);
-    return frequency;
+void publish_pitch_result(TunerPitchResult *result) {
+    result->sequence = ++pitch_result_sequence;
+    current_pitch_result.write(*result);
+}
+
+void get_pitch_result(TunerPitchResult *result) {
+    current_pitch_result.read(result);
 }
 
-void set_current_frequency(float new_frequency) {
-    portENTER_CRITICAL(&current_frequency_mutex);
-    current_frequency = new_frequency;
-    portEXIT_CRITICAL(&current_frequency_mutex);
-}
\ No newline at end of file
+float get_current_frequency() {
+    TunerPitchResult result;
+    get_pitch_result(&result);
+    return result.frequency;
+}
@@ -27,6 +27,8 @@
 #if !defined(TUNER_GLOBALS)
 #define TUNER_GLOBALS
 
+#include <stdint.h>
+
 typedef enum {
     NOTE_C = 0,
     NOTE_C_SHARP,
@@ -43,12 +45,29 @@ typedef enum {
     NOTE_NONE
 } TunerNoteName;
 
+/// @brief Everything the pitch detector knows about its latest reading.
+typedef struct {
+    float       frequency;      // Filtered frequency in Hz or -1 if no frequency is detected
+    float       rawFrequency;   // Unfiltered detector frequency in Hz or -1
+    float       periodicity;    // Detector confidence (0.0 - 1.0)
+    float       amplitude;      // Peak-to-peak of the frame as a fraction of the ADC's full range
+    int64_t     timestampUs;    // When the sample that completed the reading was captured (esp_timer time)
+    uint32_t    sequence;       // Incremented for every published result
+    uint32_t    reserved;       // Keeps the record a multiple of 8 bytes
+} TunerPitchResult;
+
+/// @brief Publishes a new pitch result from the detector task (lock-free).
+///
+/// Only the pitch detector task may call this. `result->sequence` is filled in.
+/// @param result The new result. Set `frequency` to -1 when there's no signal.
+void publish_pitch_result(TunerPitchResult *result);
+
+/// @brief Copies out the latest pitch result (lock-free, never blocks the detector).
+/// @param result Receives a consistent snapshot of the latest result.
+void get_pitch_result(TunerPitchResult *result);
+
 /// @brief Gets the currently-detected frequency (thread safe).
 /// @return The currently-detected frequency or -1 if no frequency is detected.
 float get_current_frequency();
 
-/// @brief Sets a newly-detected frequency (thread safe).
-/// @param new_frequency The newly-detected frequency or -1 if no frequency is detected.
-void set_current_frequency(float new_frequency);
-
 #endif
\ No newline at end of file
@@ -20,61 +20,255 @@
 
 #include "defines.h"
 #include "globals.h"
+#include "tuner_gui_task.h"
 #include "user_settings.h"
 
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "esp_adc/adc_continuous.h"
+#include "esp_heap_caps.h"
 #include "esp_timer.h"
 
-//
-// Q DSP Library for Pitch Detection
-//
-#include <q/pitch/pitch_detector.hpp>
-#include <q/fx/dynamic.hpp>
-#include <q/fx/clip.hpp>
-// #include <q/fx/signal_conditioner.hpp>
-#include <q/support/decibel.hpp>
-#include <q/support/duration.hpp>
-#include <q/support/literals.hpp>
-#include <q/support/pitch_names.hpp>
-#include <q/support/pitch.hpp>
-
-//
-// Smoothing Filters
-//
-#include "exponential_smoother.hpp"
-#include "OneEuroFilter.h"
-// #include "MovingAverage.hpp"
+#include "detector_profiles.h"
+#include "pitch_pipeline.h"
+#include "sample_ring.h"
+#include "seq_lock.hpp"
 
 static const char *TAG = "PitchDetector";
 
-namespace q = cycfi::q;
-using namespace q::literals;
-using std::fixed;
+static adc_channel_t channel[1] = {ADC_CHANNEL_7}; // ESP32-WROOM-32 CYD - GPIO 35 (ADC1_CH7)
 
-using namespace cycfi::q::pitch_names;
-using frequency = cycfi::q::frequency;
-using pitch = cycfi::q::pitch;
-CONSTEXPR frequency low_fs = cycfi::q::pitch_names::C[1];
-CONSTEXPR frequency high_fs = cycfi::q::pitch_names::C[7]; // Setting this higher helps to catch the high harmonics
+extern UserSettings *userSettings;
 
-static adc_channel_t channel[1] = {ADC_CHANNEL_7}; // ESP32-WROOM-32 CYD - GPIO 35 (ADC1_CH7)
+static TaskHandle_t s_task_handle;
 
-// 1EU Filter Initialization Params
-static const double euFilterFreq = EU_FILTER_ESTIMATED_FREQ; // I believe this means no guess as to what the incoming frequency will initially be
-static const double mincutoff = EU_FILTER_MIN_CUTOFF;
-static const double dcutoff = EU_FILTER_DERIVATIVE_CUTOFF;
+/// Every ADC frame is copied here by s_conv_done_cb().
+static SampleRing *s_sample_ring = NULL;
+
+/// When the ISR last wrote to the ring, so any sample's capture time can be
+/// worked out from how far it is behind `writeCount`.
+typedef struct {
+    uint32_t    writeCount;
+    uint32_t    reserved;
+    int64_t     timeUs;
+} SampleRingAnchor;
+static SeqLock<SampleRingAnchor> s_ring_anchor({});
+
+/// Every conversion the ADC has delivered (including frames the ring had to
+/// drop) and when the latest one arrived. Clock calibration compares two of
+/// these to measure the ADC's real sample rate.
+typedef struct {
+    uint32_t    conversionCount;
+    uint32_t    sampleRate;         // What the ADC was asked for
+    int64_t     timeUs;
+} ConversionAnchor;
+static SeqLock<ConversionAnchor> s_conversion_anchor({});
+static uint32_t s_conversion_count = 0; // Only touched by the ISR
+static uint32_t s_adc_sample_rate = 0;  // Set before the ADC starts
+
+static ConversionAnchor s_calibration_start = {};
+
+static PitchDetectorStats detector_stats = {};
+static portMUX_TYPE detector_stats_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+static DetectorProfileStats profile_stats[detectorProfileCount] = {};
+
+void pitch_detector_get_stats(PitchDetectorStats *stats) {
+    portENTER_CRITICAL(&detector_stats_mutex);
+    *stats = detector_stats;
+    portEXIT_CRITICAL(&detector_stats_mutex);
+
+    if (s_sample_ring != NULL) {
+        stats->framesDropped = s_sample_ring->getOverrunCount() - stats->framesSkipped;
+        stats->ringFillLevel = s_sample_ring->available();
+        stats->ringFillMaximum = s_sample_ring->getFillMaximum();
+    }
+}
 
-ExponentialSmoother smoother(DEFAULT_EXP_SMOOTHING);
-OneEuroFilter oneEUFilter(euFilterFreq, mincutoff, DEFAULT_ONE_EU_BETA, dcutoff);
-// MovingAverage movingAverage(DEFAULT_MOVING_AVG_WINDOW);
+void pitch_detector_start_clock_calibration() {
+    s_conversion_anchor.read(&s_calibration_start);
+}
 
-extern UserSettings *userSettings;
+void pitch_detector_get_clock_calibration(ClockCalibration *calibration) {
+    ConversionAnchor now;
+    s_conversion_anchor.read(&now);
+    if (now.sampleRate != s_calibration_start.sampleRate || s_calibration_start.timeUs == 0) {
+        // The profile changed (or the ADC hadn't started yet). Start over.
+        s_calibration_start = now;
+    }
+
+    int64_t elapsedUs = now.timeUs - s_calibration_start.timeUs;
+    uint32_t conversions = now.conversionCount - s_calibration_start.conversionCount; // Wraps correctly
+    *calibration = {};
+    calibration->nominalRate = (float)now.sampleRate;
+    if (elapsedUs <= 0 || now.sampleRate == 0) {
+        return;
+    }
+    calibration->progress = (float)elapsedUs / (TUNER_CLOCK_CALIBRATION_MS * 1000);
+    calibration->measuredRate = conversions * 1000000.0f / elapsedUs;
+    calibration->correction = calibration->measuredRate / now.sampleRate;
+    if (calibration->progress >= 1.0f) {
+        calibration->progress = 1.0f;
+        calibration->isComplete = true;
+    }
+}
+
+void pitch_detector_get_profile_stats(uint8_t profileIndex, DetectorProfileStats *stats) {
+    if (profileIndex >= detectorProfileCount) {
+        *stats = {};
+        return;
+    }
+    portENTER_CRITICAL(&detector_stats_mutex);
+    *stats = profile_stats[profileIndex];
+    portEXIT_CRITICAL(&detector_stats_mutex);
+}
+
+/// @brief Add one window's processing time and latency to its profile's totals.
+static void update_profile_stats(uint8_t profileIndex, int64_t processingUs, int64_t audioUs, int64_t latencyUs) {
+    portENTER_CRITICAL(&detector_stats_mutex);
+    DetectorProfileStats *stats = &profile_stats[profileIndex];
+    stats->windowsProcessed++;
+    stats->processingUs += processingUs;
+    stats->audioUs += audioUs;
+    stats->latencyTotalUs += latencyUs;
+    if (latencyUs > stats->latencyMaxUs) {
+        stats->latencyMaxUs = latencyUs;
+    }
+    portEXIT_CRITICAL(&detector_stats_mutex);
+}
+
+static void log_profile_stats(uint8_t profileIndex) {
+    DetectorProfileStats stats;
+    pitch_detector_get_profile_stats(profileIndex, &stats);
+    if (stats.windowsProcessed == 0 || stats.audioUs == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "%s: %lu windows, CPU load %.1f%%, latency mean %lldus max %lldus",
+        detector_profile_get(profileIndex)->name,
+        (unsigned long)stats.windowsProcessed,
+        100.0f * stats.processingUs / stats.audioUs,
+        stats.latencyTotalUs / stats.windowsProcessed,
+        stats.latencyMaxUs);
+}
+
+/// @brief Builds the reading chain's settings from the user's.
+static ReadingChainSettings reading_chain_settings() {
+    ReadingChainSettings settings = reading_chain_default_settings();
+    settings.use1EUFilterFirst = userSettings->use1EUFilterFirst;
+    settings.expSmoothing = userSettings->expSmoothing;
+    settings.oneEUBeta = userSettings->oneEUBeta;
+    settings.readingFilterType = userSettings->readingFilterType;
+    settings.readingFilterWindow = (uint8_t)userSettings->readingFilterWindow;
+    return settings;
+}
+
+static void log_chain_stats(PitchPipeline *pipeline) {
+    const ReadingStageStats *stats;
+    size_t stageCount = pipeline->getChainStats(&stats);
+    for (size_t i = 0; i < stageCount; i++) {
+        if (stats[i].readings == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %s: %lu readings, mean %llu %s", stats[i].name, (unsigned long)stats[i].readings,
+            stats[i].cycles / stats[i].readings, TUNER_CYCLE_COUNT_UNITS);
+    }
+}
+
+static void log_onset_stats(PitchPipeline *pipeline) {
+    const PitchOnsetStats &stats = pipeline->getOnsetStats();
+    const SampleClock &clock = pipeline->getClock();
+    if (stats.coldOnsets > 0) {
+        ESP_LOGI(TAG, "First reading %lldus after %lu cold onsets (mean)",
+            clock.durationUs(stats.coldSamples / stats.coldOnsets), (unsigned long)stats.coldOnsets);
+    }
+    if (stats.relockOnsets > 0) {
+        ESP_LOGI(TAG, "First reading %lldus after %lu re-locks (mean)",
+            clock.durationUs(stats.relockSamples / stats.relockOnsets), (unsigned long)stats.relockOnsets);
+    }
+}
+
+/// @brief Track the heap around each frame to prove the sample path doesn't allocate.
+///
+/// After TUNER_HEAP_WATERMARK_WARMUP_FRAMES, any frame where the free heap is
+/// lower after processing than before is counted (and logged). Other tasks can
+/// allocate at the same time so this can over-count, but it never under-counts.
+static void update_heap_watermark(size_t heapFreeBefore, size_t heapFreeAfter) {
+    bool didAllocate = false;
+    portENTER_CRITICAL(&detector_stats_mutex);
+    detector_stats.framesProcessed++;
+    detector_stats.heapFreeMinimum = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    if (detector_stats.framesProcessed == TUNER_HEAP_WATERMARK_WARMUP_FRAMES) {
+        detector_stats.heapFreeBaseline = heapFreeAfter;
+    } else if (detector_stats.framesProcessed > TUNER_HEAP_WATERMARK_WARMUP_FRAMES && heapFreeAfter < heapFreeBefore) {
+        detector_stats.heapAllocatingFrames++;
+        didAllocate = true;
+    }
+    portEXIT_CRITICAL(&detector_stats_mutex);
+
+    if (didAllocate) {
+        ESP_LOGW(TAG, "Free heap dropped %d bytes while processing a frame", (int)(heapFreeBefore - heapFreeAfter));
+    }
+}
+
+// Set when the frame being processed published at least one result, so the
+// GUI is only woken once per frame.
+static bool frame_published_result = false;
+
+// Set once "no signal" has been published so silent frames don't keep waking
+// the GUI with identical results.
+static bool is_no_signal_published = false;
+
+static void pitch_reading_cb(const PitchReading *reading, void *userData) {
+    TunerPitchResult result = {
+        .frequency = reading->frequency,
+        .rawFrequency = reading->rawFrequency,
+        .periodicity = reading->periodicity,
+        .amplitude = reading->amplitude,
+        .timestampUs = reading->timeUs,
+    };
+    publish_pitch_result(&result);
+    frame_published_result = true;
+    is_no_signal_published = false;
+}
+
+/// @brief Tell the UI that there's no frequency available.
+static void publish_no_signal(int64_t timeUs) {
+    if (is_no_signal_published) {
+        return;
+    }
+    is_no_signal_published = true;
+
+    TunerPitchResult result = {
+        .frequency = -1.0f,
+        .rawFrequency = -1.0f,
+        .timestampUs = timeUs,
+    };
+    publish_pitch_result(&result);
+    tuner_gui_task_pitch_result_available();
+}
 
-static TaskHandle_t s_task_handle;
 static bool IRAM_ATTR s_conv_done_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data)
 {
+    // Copy the frame into the ring before the driver reuses its DMA buffer.
+    // If the ring is full the frame is dropped and counted as an overrun.
+    const uint16_t *words = (const uint16_t *)edata->conv_frame_buffer;
+    uint32_t count = edata->size / SOC_ADC_DIGI_RESULT_BYTES;
+    int64_t timeUs = esp_timer_get_time();
+    s_conversion_count += count;
+    ConversionAnchor conversions = {
+        .conversionCount = s_conversion_count,
+        .sampleRate = s_adc_sample_rate,
+        .timeUs = timeUs,
+    };
+    s_conversion_anchor.write(conversions);
+    if (s_sample_ring->write(words, count)) {
+        SampleRingAnchor anchor = {
+            .writeCount = s_sample_ring->getWriteCount(),
+            .timeUs = timeUs,
+        };
+        s_ring_anchor.write(anchor);
+    }
+
     BaseType_t mustYield = pdFALSE;
     //Notify that ADC continuous driver has done enough number of conversions
     vTaskNotifyGiveFromISR(s_task_handle, &mustYield);
@@ -82,16 +276,39 @@ static bool IRAM_ATTR s_conv_done_cb(adc_continuous_handle_t handle, const adc_c
     return (mustYield == pdTRUE);
 }
 
-static void continuous_adc_init(adc_channel_t *channel, uint8_t channel_count, adc_continuous_handle_t *out_handle)
+/// @brief Capture time of a sample that's in (or has been through) the ring.
+static int64_t sample_ring_time_us(uint32_t sampleIndex, const SampleClock &clock) {
+    SampleRingAnchor anchor;
+    s_ring_anchor.read(&anchor);
+    uint32_t samplesBehind = anchor.writeCount - sampleIndex; // Wraps correctly
+    return anchor.timeUs - clock.durationUs(samplesBehind);
+}
+
+static void update_backlog_maximum(uint32_t windowsProcessed) {
+    portENTER_CRITICAL(&detector_stats_mutex);
+    if (windowsProcessed > detector_stats.backlogWindowsMaximum) {
+        detector_stats.backlogWindowsMaximum = windowsProcessed;
+    }
+    portEXIT_CRITICAL(&detector_stats_mutex);
+}
+
+static void continuous_adc_init(adc_channel_t *channel, uint8_t channel_count, const DetectorProfile *profile, adc_continuous_handle_t *out_handle)
 {
     adc_continuous_handle_t handle = NULL;
 
+    // One frame of pool. Frames are read from the ISR into the sample ring
+    // (see TUNER_SAMPLE_RING_SAMPLES), never from the pool, so keep it small.
+    uint32_t frameSize = profile->frameSamples * SOC_ADC_DIGI_RESULT_BYTES;
     adc_continuous_handle_cfg_t adc_config = {
-        .max_store_buf_size = TUNER_ADC_BUFFER_POOL_SIZE,
-        .conv_frame_size = TUNER_ADC_FRAME_SIZE,
+        .max_store_buf_size = frameSize,
+        .conv_frame_size = frameSize,
         .flags = {
-            // .flush_pool = false,
-            .flush_pool = true,
+            // Frames are taken from s_conv_done_cb() and nothing reads the
+            // driver's pool, so once it's full the driver just skips storing
+            // new frames there. Flushing it every frame would only waste time
+            // in the ISR.
+            .flush_pool = false,
+            // .flush_pool = true,
         },
     };
     ESP_ERROR_CHECK(adc_continuous_new_handle(&adc_config, &handle));
@@ -111,7 +328,7 @@ static void continuous_adc_init(adc_channel_t *channel, uint8_t channel_count, a
     adc_continuous_config_t dig_cfg = {
         .pattern_num = channel_count,
         .adc_pattern = adc_pattern,
-        .sample_freq_hz = TUNER_ADC_SAMPLE_RATE,
+        .sample_freq_hz = profile->sampleRate,
         .conv_mode = TUNER_ADC_CONV_MODE,
         .format = TUNER_ADC_OUTPUT_TYPE,
     };
@@ -122,53 +339,18 @@ static void continuous_adc_init(adc_channel_t *channel, uint8_t channel_count, a
     *out_handle = handle;
 }
 
-void pitch_detector_task(void *pvParameter) {
-    // Prep ADC
-    esp_err_t ret;
-    uint32_t num_of_bytes_read = 0;
-    uint8_t *adc_buffer = (uint8_t *)malloc(TUNER_ADC_FRAME_SIZE);
-    if (adc_buffer == NULL) {
-        ESP_LOGI(TAG, "Failed to allocate memory for buffer");
-        return;
-    }
-    memset(adc_buffer, 0xcc, TUNER_ADC_FRAME_SIZE);
-
-    // Get the pitch detector ready
-    q::pitch_detector   pd(low_fs, high_fs, TUNER_ADC_SAMPLE_RATE, -40_dB);
-
-    // Use `lastFrequencyRecordedTime` to know elapsed time since
-    // the frequency was updated for the UI to read. Don't update
-    // more frequently than `minIntervalForFrequencyUpdate`.
-    int64_t lastFrequencyRecordedTime = esp_timer_get_time();
-
-    // Don't update the UI more frequently than this interval
-    int64_t minIntervalForFrequencyUpdate = 50 * 1000; // 50ms
-
-    // auto const&                 bits = pd.bits();
-    // auto const&                 edges = pd.edges();
-    // q::bitstream_acf<>          bacf{ bits };
-    // auto                        min_period = as_float(high_fs.period()) * TUNER_ADC_SAMPLE_RATE;
-    
-    // q::peak_envelope_follower   env{ 30_ms, TUNER_ADC_SAMPLE_RATE };
-    // q::one_pole_lowpass         lp{high_fs, TUNER_ADC_SAMPLE_RATE};
-    // q::one_pole_lowpass         lp2(low_fs, TUNER_ADC_SAMPLE_RATE);
-
-    // constexpr float             slope = 1.0f/2;
-    // constexpr float             makeup_gain = 2;
-    // q::compressor               comp{ -18_dB, slope };
-    // q::clip                     clip;
-
-    // float                       onset_threshold = lin_float(-28_dB);
-    // float                       release_threshold = lin_float(-60_dB);
-    // float                       threshold = onset_threshold;
-
-    // auto sc_conf = q::signal_conditioner::config{};
-    // auto sig_cond = q::signal_conditioner{sc_conf, low_fs, high_fs, TUNER_ADC_SAMPLE_RATE};
+/// @brief Checks that the ADC can run a profile. The frame and window sizes
+/// are checked against the sample ring when detector_profiles.cpp compiles.
+static bool is_profile_usable(const DetectorProfile *profile) {
+    return profile->sampleRate >= SOC_ADC_SAMPLE_FREQ_THRES_LOW
+        && profile->sampleRate <= SOC_ADC_SAMPLE_FREQ_THRES_HIGH;
+}
 
-    s_task_handle = xTaskGetCurrentTaskHandle();
-    
+/// @brief Set up the ADC for a profile and start it filling the ring.
+static adc_continuous_handle_t start_adc(const DetectorProfile *profile) {
     adc_continuous_handle_t handle = NULL;
-    continuous_adc_init(channel, sizeof(channel) / sizeof(adc_channel_t), &handle);
+    s_adc_sample_rate = profile->sampleRate;
+    continuous_adc_init(channel, sizeof(channel) / sizeof(adc_channel_t), profile, &handle);
 
     adc_continuous_evt_cbs_t cbs = {
         .on_conv_done = s_conv_done_cb,
@@ -177,156 +359,153 @@ void pitch_detector_task(void *pvParameter) {
     ESP_ERROR_CHECK(adc_continuous_start(handle));
 
     // adc_ll_digi_set_convert_limit_num(2); // potential hack for the ESP32 ADC bug
+    return handle;
+}
+
+static void stop_adc(adc_continuous_handle_t handle) {
+    ESP_ERROR_CHECK(adc_continuous_stop(handle));
+    ESP_ERROR_CHECK(adc_continuous_deinit(handle));
+}
+
+/// @brief Returns the profile index to use, falling back to the standard
+/// profile if the saved one can't run.
+static uint8_t selected_profile_index() {
+    uint8_t profileIndex = userSettings != NULL ? userSettings->detectorProfileIndex : DEFAULT_DETECTOR_PROFILE_INDEX;
+    if (profileIndex >= detectorProfileCount || !is_profile_usable(detector_profile_get(profileIndex))) {
+        profileIndex = detectorProfileStandard;
+    }
+    return profileIndex;
+}
+
+/// @brief Returns this device's sample clock correction at the profile's
+/// sample rate (see DEFAULT_SAMPLE_CLOCK_CORRECTION).
+static float sample_clock_correction(uint8_t profileIndex) {
+    return userSettings != NULL ? userSettings->sampleClockCorrections[profileIndex] : DEFAULT_SAMPLE_CLOCK_CORRECTION;
+}
+
+void pitch_detector_task(void *pvParameter) {
+    // Get the pitch detector ready. All of the buffers used while processing
+    // samples are allocated here, once (and again only when the profile
+    // changes).
+    static_assert(TUNER_ADC_OUTPUT_TYPE == ADC_DIGI_OUTPUT_FORMAT_TYPE1 && sizeof(adc_digi_output_data_t) == sizeof(uint16_t), "adc_frame_kernels.h only unpacks 16-bit type1 results");
+    static_assert((TUNER_SAMPLE_RING_SAMPLES & (TUNER_SAMPLE_RING_SAMPLES - 1)) == 0, "TUNER_SAMPLE_RING_SAMPLES must be a power of two");
+    s_sample_ring = new SampleRing(TUNER_SAMPLE_RING_SAMPLES);
+
+    uint8_t profileIndex = selected_profile_index();
+    const DetectorProfile *profile = detector_profile_get(profileIndex);
+    PitchPipeline *pipeline = new PitchPipeline(detector_profile_pipeline_config(profile, sample_clock_correction(profileIndex)));
+
+    // The chain is rebuilt from the user settings whenever they're saved
+    // (or the pipeline is rebuilt)
+    uint32_t chainGeneration = UINT32_MAX;
+
+    s_task_handle = xTaskGetCurrentTaskHandle();
+
+    ESP_LOGI(TAG, "Starting with the %s profile", profile->name);
+    adc_continuous_handle_t handle = start_adc(profile);
 
+    uint32_t lastOverrunCount = 0;
     while (1) {
-        /**
-         * This is to show you the way to use the ADC continuous mode driver event callback.
-         * This `ulTaskNotifyTake` will block when the data processing in the task is fast.
-         * However in this example, the data processing (print) is slow, so you barely block here.
-         *
-         * Without using this event callback (to notify this task), you can still just call
-         * `adc_continuous_read()` here in a loop, with/without a certain block timeout.
-         */
+        // Block until the ISR has added a frame to the ring. Then process
+        // every window that's ready without sleeping. If the detector can't
+        // keep up, the ring fills and the dropped frames show up in
+        // PitchDetectorStats.
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-        while (1) {
-            if (userSettings == NULL || userSettings->isShowingSettings()) {
-                // Don't read the signal when the settings menu is showing.
-                vTaskDelay(pdMS_TO_TICKS(500));
-                continue;
+        if (userSettings == NULL || userSettings->isShowingSettings()) {
+            // Don't read the signal when the settings menu is showing. The
+            // ADC keeps running (for Calibrate Clock), so the ring overruns
+            // while the task sleeps. Those frames were skipped, not lost to
+            // the detector falling behind, so they don't count as dropped.
+            vTaskDelay(pdMS_TO_TICKS(500));
+            s_sample_ring->consume(s_sample_ring->available());
+            uint32_t overrunCount = s_sample_ring->getOverrunCount();
+            portENTER_CRITICAL(&detector_stats_mutex);
+            detector_stats.framesSkipped += overrunCount - lastOverrunCount;
+            portEXIT_CRITICAL(&detector_stats_mutex);
+            lastOverrunCount = overrunCount;
+            pipeline->reset(); // There's a gap in the stream either way
+            continue;
+        }
+
+        if (selected_profile_index() != profileIndex || sample_clock_correction(profileIndex) != pipeline->getConfig().sampleClockCorrection) {
+            // Rebuild the ADC and the detector for the new profile (or the
+            // newly calibrated clock). The ISR is stopped while the ring is
+            // emptied so it starts clean.
+            log_profile_stats(profileIndex);
+            log_chain_stats(pipeline);
+            log_onset_stats(pipeline);
+            ESP_LOGI(TAG, "Noise floor %.1f counts RMS (gate opens at %.1f)",
+                pipeline->getNoiseGate().getNoiseFloor(), pipeline->getNoiseGate().getOnsetLevel());
+            stop_adc(handle);
+            s_sample_ring->consume(s_sample_ring->available());
+            delete pipeline;
+
+            profileIndex = selected_profile_index();
+            profile = detector_profile_get(profileIndex);
+            pipeline = new PitchPipeline(detector_profile_pipeline_config(profile, sample_clock_correction(profileIndex)));
+            chainGeneration = UINT32_MAX;
+            lastOverrunCount = s_sample_ring->getOverrunCount();
+            ESP_LOGI(TAG, "Switched to the %s profile (clock correction %.6f)", profile->name, pipeline->getConfig().sampleClockCorrection);
+            handle = start_adc(profile);
+            continue;
+        }
+
+        uint32_t settingsGeneration = userSettings->getSettingsGeneration();
+        if (settingsGeneration != chainGeneration) {
+            if (chainGeneration != UINT32_MAX) {
+                ESP_LOGI(TAG, "Settings changed. Reading chain so far:");
+                log_chain_stats(pipeline);
             }
+            pipeline->configureChain(reading_chain_settings());
+            chainGeneration = settingsGeneration;
+        }
+
+        // A dropped frame is a gap in the stream. Start the detector over
+        // instead of measuring a period across the gap.
+        uint32_t overrunCount = s_sample_ring->getOverrunCount();
+        if (overrunCount != lastOverrunCount) {
+            lastOverrunCount = overrunCount;
+            pipeline->reset();
+        }
 
-            std::vector<float> in(TUNER_ADC_FRAME_SIZE); // a vector of values to pass into qlib
-
-            ret = adc_continuous_read(handle, adc_buffer, TUNER_ADC_FRAME_SIZE, &num_of_bytes_read, portMAX_DELAY);
-            if (ret == ESP_OK) {
-                // ESP_LOGI(TAG, "ret is %x, num_of_bytes_read is %"PRIu32" bytes", ret, num_of_bytes_read);
-
-                // Get the data out of the ADC Conversion Result.
-                int valuesStored = 0;
-                float maxVal = 0;
-                float minVal = MAXFLOAT;
-                // ESP_LOGI(TAG, "Bytes read: %ld", num_of_bytes_read);
-                for (int i = 0; i < num_of_bytes_read; i += SOC_ADC_DIGI_RESULT_BYTES, valuesStored++) {
-                    adc_digi_output_data_t *p = (adc_digi_output_data_t*)&adc_buffer[i];
-                    // if (i == 20) {
-                    //     ESP_LOGI(TAG, "read value is: %d", TUNER_ADC_GET_DATA(p));
-                    // }
-
-                    // Do a first pass by just storing the raw values into the float array
-                    in[valuesStored] = TUNER_ADC_GET_DATA(p);
-
-                    // Track the min and max values we see so we can convert to values between -1.0f and +1.0f
-                    if (in[valuesStored] > maxVal) {
-                        maxVal = in[valuesStored];
-                    }
-                    if (in[valuesStored] < minVal) {
-                        minVal = in[valuesStored];
-                    }
-                }
-
-                // Bail out if the input does not meet the minimum criteria
-                float range = maxVal - minVal;
-                if (range < TUNER_READING_DIFF_MINIMUM) {
-                    set_current_frequency(-1); // Indicate to the UI that there's no frequency available
-                    oneEUFilter.reset(); // Reset the 1EU filter so the next frequency it detects will be as fast as possible
-                    smoother.reset();
-                    // movingAverage.reset();
-                    pd.reset();
-                    vTaskDelay(10 / portTICK_PERIOD_MS); // Should be 10ms?
-                    continue;
-                }
-
-                // ESP_LOGI(TAG, "Min: %f, Max: %f, peak-to-peak: %f", minVal, maxVal, range);
-                oneEUFilter.setBeta(userSettings->oneEUBeta);
-                smoother.setAmount(userSettings->expSmoothing);
-
-                // Normalize the values between -1.0 and +1.0 before processing with qlib.
-                float midVal = range / 2;
-                // ESP_LOGI("min, max, range, mid:", "%f, %f, %f, %f", minVal, maxVal, range, midVal);
-                for (auto i = 0; i < valuesStored; i++) {
-                    // ESP_LOGI("adc", "%f", in[i]);
-                    float newPosition = in[i] - midVal - minVal;
-                    float normalizedValue = newPosition / midVal;
-                    // ESP_LOGI("norm-val", "%f is now %f", in[i], normalizedValue);
-                    in[i] = normalizedValue;
-
-                    auto s = in[i]; // input signal
-
-                    // I've got the signal conditioning commented out right now
-                    // because it actually is making the frequency readings
-                    // NOT work. They probably just need to be tweaked a little.
-
-                    // Signal Conditioner
-                    // s = sig_cond(s);
-
-                    // // Bandpass filter
-                    // s = lp(s);
-                    // s -= lp2(s);
-
-                    // // Envelope
-                    // auto e = env(std::abs(static_cast<int>(s)));
-                    // auto e_db = q::lin_to_db(e);
-
-                    // if (e > threshold) {
-                    //     // Compressor + make-up gain + hard clip
-                    //     auto gain = cycfi::q::lin_float(comp(e_db)) * makeup_gain;
-                    //     s = clip(s * gain);
-                    //     threshold = release_threshold;
-                    // } else {
-                    //     s = 0.0f;
-                    //     threshold = onset_threshold;
-                    // }
-
-                    int64_t time_us = esp_timer_get_time(); // Get time in microseconds
-                    int64_t time_ms = time_us / 1000; // Convert to milliseconds
-                    int64_t time_seconds = time_us / 1000000;    // Convert to seconds
-                    // int64_t elapsedTimeSinceLastUpdate = time_us - lastFrequencyRecordedTime;
-
-                    // Pitch Detect
-                    // Send in each value into the pitch detector
-                    // if (pd(s) == true && elapsedTimeSinceLastUpdate >= minIntervalForFrequencyUpdate) { // calculated a frequency
-                    if (pd(s) == true) { // calculated a frequency
-                        auto f = pd.get_frequency();
-
-                        bool use1EUFilterFirst = true; // TODO: This may never be needed. Need to test which "feels" better for tuning
-                        if (use1EUFilterFirst) {
-                            // 1EU Filtering
-                            f = (float)oneEUFilter.filter((double)f, (TimeStamp)time_seconds);
-
-                            // Simple Exponential Smoothing
-                            f = smoother.smooth(f);
-                        } else {
-                            // Simple Expoential Smoothing
-                            f = smoother.smooth(f);
-
-                            // 1EU Filtering
-                            f = (float)oneEUFilter.filter((double)f, (TimeStamp)time_seconds);
-                        }
-
-                        // Moving average (makes it BAD!)
-                        // f = movingAverage.addValue(f);
-                        f = f / WEIRD_ESP32_WROOM_32_FREQ_FIX_FACTOR; // Use the weird factor only on ESP32-WROOM-32 (which the CYD is)
-                        set_current_frequency(f);
-                    }
-                }
-
-                /**
-                 * Because printing is slow, so every time you call `ulTaskNotifyTake`, it will immediately return.
-                 * To avoid a task watchdog timeout, add a delay here. When you replace the way you process the data,
-                 * usually you don't need this delay (as this task will block for a while).
-                 */
-                // vTaskDelay(1); // potentially no longer needed
-                vTaskDelay(10 / portTICK_PERIOD_MS); // Should be 10ms?
-            } else if (ret == ESP_ERR_TIMEOUT) {
-                //We try to read `EXAMPLE_READ_LEN` until API returns timeout, which means there's no available data
-                break;
+        uint32_t windowSamples = profile->windowSamples;
+        uint32_t hopSamples = profile->frameSamples;
+        int64_t hopUs = pipeline->getClock().durationUs(hopSamples);
+        uint32_t windowsProcessed = 0;
+        const uint16_t *window;
+        while ((window = s_sample_ring->peek(windowSamples)) != NULL) {
+            windowsProcessed++;
+
+            size_t heapFreeBefore = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+
+            // The window points straight into the ring. Only the last
+            // `hopSamples` of it haven't been seen before.
+            uint32_t firstNewSample = s_sample_ring->getReadCount() + windowSamples - hopSamples;
+            int64_t windowStartUs = sample_ring_time_us(firstNewSample, pipeline->getClock());
+            frame_published_result = false;
+            int64_t processingStartUs = esp_timer_get_time();
+            PitchFrameResult result = pipeline->processWindow(window, windowSamples, hopSamples, windowStartUs, pitch_reading_cb, NULL);
+            int64_t processingEndUs = esp_timer_get_time();
+            s_sample_ring->consume(hopSamples);
+
+            // Latency is from the capture of the window's newest sample
+            update_profile_stats(profileIndex, processingEndUs - processingStartUs, hopUs, processingEndUs - (windowStartUs + hopUs));
+
+            if (frame_published_result) {
+                tuner_gui_task_pitch_result_available();
+            }
+            update_heap_watermark(heapFreeBefore, heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+            if (result == pitchFrameNoSignal) {
+                publish_no_signal(windowStartUs); // Indicate to the UI that there's no frequency available
             }
         }
+        update_backlog_maximum(windowsProcessed);
     }
 
-    free(adc_buffer);
+    delete pipeline;
 
-    ESP_ERROR_CHECK(adc_continuous_stop(handle));
-    ESP_ERROR_CHECK(adc_continuous_deinit(handle));
+    stop_adc(handle);
+    delete s_sample_ring;
+    s_sample_ring = NULL;
 }
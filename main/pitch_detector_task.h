@@ -19,4 +19,59 @@
 #if !defined(TUNER_PITCH_DETECTOR_TASK)
 #define TUNER_PITCH_DETECTOR_TASK
 
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Counters kept by the pitch detector task.
+typedef struct {
+    uint32_t    framesProcessed;        // Frames read from the ADC and run through the pipeline
+    size_t      heapFreeBaseline;       // Free heap once the detector warmed up (0 until then)
+    size_t      heapFreeMinimum;        // Lowest free heap seen since boot
+    uint32_t    heapAllocatingFrames;   // Frames (after warm-up) where the free heap dropped while the frame was processed
+    uint32_t    framesDropped;          // ADC frames dropped because the sample ring was full (the detector fell behind)
+    uint32_t    framesSkipped;          // ADC frames let go on purpose while the settings menu was showing (not in framesDropped)
+    uint32_t    backlogWindowsMaximum;  // Most windows processed after a single wake-up
+    uint32_t    ringFillLevel;          // Samples currently waiting in the sample ring
+    uint32_t    ringFillMaximum;        // Most samples that have waited in the sample ring at once
+} PitchDetectorStats;
+
+/// @brief How a detector profile (see detector_profiles.h) has performed since boot.
+typedef struct {
+    uint32_t    windowsProcessed;
+    uint64_t    processingUs;       // Time spent in the pitch pipeline
+    uint64_t    audioUs;            // Audio covered by those windows. processingUs / audioUs is the CPU load.
+    int64_t     latencyTotalUs;     // From capture of a window's last sample to the end of processing it. Divide by windowsProcessed for the mean.
+    int64_t     latencyMaxUs;
+} DetectorProfileStats;
+
+/// @brief Progress of a sample clock measurement.
+typedef struct {
+    bool        isComplete;     // TUNER_CLOCK_CALIBRATION_MS have gone by
+    float       progress;       // 0.0 - 1.0
+    float       nominalRate;    // Samples per second the ADC was asked for
+    float       measuredRate;   // Samples per second it really delivered (so far)
+    float       correction;     // measuredRate / nominalRate (see DEFAULT_SAMPLE_CLOCK_CORRECTION)
+} ClockCalibration;
+
+/// @brief Start measuring the ADC's real sample rate.
+///
+/// The ADC keeps running while the settings menu is showing, so this works
+/// from there. It counts every conversion the ADC delivers against esp_timer,
+/// so it needs no input signal. Only call this and
+/// `pitch_detector_get_clock_calibration()` from one task (the GUI).
+void pitch_detector_start_clock_calibration();
+
+/// @brief How the measurement started by `pitch_detector_start_clock_calibration()` is going.
+/// @param calibration Filled in with the measurement so far.
+void pitch_detector_get_clock_calibration(ClockCalibration *calibration);
+
+/// @brief Gets a copy of the pitch detector counters (thread safe).
+/// @param stats Filled in with the current counters.
+void pitch_detector_get_stats(PitchDetectorStats *stats);
+
+/// @brief Gets the CPU load and latency of a detector profile (thread safe).
+/// @param profileIndex A `DetectorProfileIndex`.
+/// @param stats Filled in with the profile's numbers (zeros if it never ran).
+void pitch_detector_get_profile_stats(uint8_t profileIndex, DetectorProfileStats *stats);
+
 #endif
@@ -30,7 +30,8 @@
 #include "esp_adc/adc_continuous.h"
 #include "esp_timer.h"
 
-#include <cmath> // for log2()
+#include "note_debouncer.hpp"
+#include "numeric_policy.hpp"
 
 //
 // These are the tuner UIs available.
@@ -63,12 +64,14 @@ void create_tuning_ui();
 void create_settings_ui();
 
 float midi_note_from_frequency(float freq);
-TunerNoteName get_pitch_name_and_cents_from_frequency(float freq, float *cents);
 void create_standby_ui();
 void create_tuning_ui();
 void settings_button_cb(lv_event_t *e);
 void create_settings_menu_button(lv_obj_t * parent);
 static esp_err_t app_lvgl_main();
+static void gui_flush_finish_cb(lv_event_t *e);
+static void gui_stats_result_drawn(int64_t timestampUs, bool isNoteChange);
+static void gui_stats_log_latency();
 
 lv_coord_t screen_width = 0;
 lv_coord_t screen_height = 0;
@@ -78,6 +81,11 @@ lv_obj_t *main_screen = NULL;
 
 bool is_gui_loaded = false;
 
+/// Holds the displayed note steady until a new one has lasted
+/// `UserSettings::noteDebounceInterval` so the note name image isn't swapped
+/// on every wobble. Only used by the GUI task.
+static NoteDebouncer note_debouncer;
+
 /// This variable is used to keep track of what state the UI is in. Initially
 /// the code would try to rebuild the UI inside of the button press handling of
 /// gpio_task but that was causing problems probably because not much memory is
@@ -86,6 +94,22 @@ bool is_gui_loaded = false;
 TunerState current_ui_tuner_state = tunerStateBooting;
 portMUX_TYPE current_ui_tuner_state_mutex = portMUX_INITIALIZER_UNLOCKED;
 
+/// The pitch detector and tuner state changes notify this task so it only
+/// wakes up when there's something new to draw.
+static TaskHandle_t gui_task_handle = NULL;
+
+/// Display latency stats. `pending_flush_timestamp_us` is the ADC capture time
+/// of the pitch result that was just drawn but not yet flushed (0 if none).
+/// `refresh_flush_bytes` adds up the flushes of the refresh in progress and
+/// `is_note_change_pending` is set when it shows a different note.
+TunerGUIStats gui_stats = {
+    .latencyMinUs = INT64_MAX,
+};
+static int64_t pending_flush_timestamp_us = 0;
+static uint32_t refresh_flush_bytes = 0;
+static bool is_note_change_pending = false;
+portMUX_TYPE gui_stats_mutex = portMUX_INITIALIZER_UNLOCKED;
+
 //
 // GPIO Footswitch and Relay Pin Variables
 //
@@ -172,6 +196,8 @@ TunerGUIInterface get_active_gui() {
 ///
 /// @param pvParameter User data (unused).
 void tuner_gui_task(void *pvParameter) {
+    gui_task_handle = xTaskGetCurrentTaskHandle();
+
     esp_lcd_panel_io_handle_t lcd_io;
     esp_lcd_panel_handle_t lcd_panel;
     esp_lcd_touch_handle_t tp;
@@ -196,6 +222,7 @@ void tuner_gui_task(void *pvParameter) {
         ESP_ERROR_CHECK(lcd_display_brightness_set(userSettings->displayBrightness * 100));
         ESP_ERROR_CHECK(lcd_display_rotate(lvgl_display, userSettings->getDisplayOrientation()));
         // ESP_ERROR_CHECK(lcd_display_rotate(lvgl_display, LV_DISPLAY_ROTATION_0)); // Upside Down
+        lv_display_add_event_cb(lvgl_display, gui_flush_finish_cb, LV_EVENT_FLUSH_FINISH, NULL);
         lvgl_port_unlock();
     }
 
@@ -213,9 +240,16 @@ void tuner_gui_task(void *pvParameter) {
     TunerState initial_state = userSettings->initialState;
     tunerController->setState(initial_state);
 
+    uint32_t last_drawn_sequence = 0;
+    TunerNoteName last_drawn_note = NOTE_NONE; // For counting the bytes a note change flushes
+
     while(1) {
         // handle_gpio_pins();
 
+        // Sleep until the pitch detector publishes a new result or the tuner
+        // state changes. The timeout keeps LVGL serviced when nothing arrives.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TUNER_GUI_IDLE_TIMEOUT_MS));
+
         lv_task_handler();
 
         TunerState newState = tunerStateBooting;
@@ -226,23 +260,40 @@ void tuner_gui_task(void *pvParameter) {
         if (old_tuner_ui_state != current_ui_tuner_state) {
             update_ui(old_tuner_ui_state, current_ui_tuner_state);
             old_tuner_ui_state = current_ui_tuner_state;
+            last_drawn_sequence = 0; // Draw the latest result on the new UI
+            note_debouncer.reset(); // And show its note right away
+            last_drawn_note = NOTE_NONE;
         }
 
         if (current_ui_tuner_state == tunerStateTuning && lvgl_port_lock(0)) {
-            float frequency = get_current_frequency();
-            if (frequency > 0) {
-                TunerNoteName note_name = get_pitch_name_and_cents_from_frequency(frequency, &cents);
-                // ESP_LOGI(TAG, "%s - %d", noteName, cents);
-                get_active_gui().display_frequency(frequency, note_name, cents);
-            } else {
-                get_active_gui().display_frequency(0, NOTE_NONE, 0);
+            TunerPitchResult pitchResult;
+            get_pitch_result(&pitchResult); // Consistent snapshot without stalling the detector
+            bool is_new_result = pitchResult.sequence != last_drawn_sequence;
+            if (is_new_result) {
+                last_drawn_sequence = pitchResult.sequence;
+                float frequency = pitchResult.frequency;
+                TunerNoteName note_name = NOTE_NONE;
+                if (frequency > 0) {
+                    note_name = note_debouncer.update(frequency, pitchResult.timestampUs, userSettings->noteDebounceInterval, &cents);
+                    // ESP_LOGI(TAG, "%s - %d", noteName, cents);
+                    get_active_gui().display_frequency(frequency, note_name, cents, pitchResult.timestampUs);
+                } else {
+                    note_debouncer.reset();
+                    get_active_gui().display_frequency(0, NOTE_NONE, 0, pitchResult.timestampUs);
+                }
+                gui_stats_result_drawn(pitchResult.timestampUs, note_name != last_drawn_note);
+                last_drawn_note = note_name;
             }
             // Release the mutex
             lvgl_port_unlock();
-            vTaskDelay(pdMS_TO_TICKS(125)); // Yields to reset watchdog in milliseconds
-        } else {
-            // Nothing to do
-            vTaskDelay(pdMS_TO_TICKS(200));
+
+            if (is_new_result) {
+                gui_stats_log_latency();
+
+                // Results that arrive during this delay are coalesced into the
+                // next redraw, which caps redraws at TUNER_GUI_MAX_FPS.
+                vTaskDelay(pdMS_TO_TICKS(1000 / TUNER_GUI_MAX_FPS));
+            }
         }
     }
     vTaskDelay(portMAX_DELAY);
@@ -298,6 +349,93 @@ void tuner_gui_task_tuner_state_changed(TunerState old_state, TunerState new_sta
     portENTER_CRITICAL(&current_ui_tuner_state_mutex);
     current_ui_tuner_state = new_state;
     portEXIT_CRITICAL(&current_ui_tuner_state_mutex);
+
+    if (gui_task_handle != NULL) {
+        xTaskNotifyGive(gui_task_handle);
+    }
+}
+
+void tuner_gui_task_pitch_result_available() {
+    if (gui_task_handle != NULL) {
+        xTaskNotifyGive(gui_task_handle);
+    }
+}
+
+void tuner_gui_get_stats(TunerGUIStats *stats) {
+    portENTER_CRITICAL(&gui_stats_mutex);
+    *stats = gui_stats;
+    portEXIT_CRITICAL(&gui_stats_mutex);
+}
+
+/// @brief Remember when the reading that was just drawn was captured so the
+/// next flush can measure the latency.
+static void gui_stats_result_drawn(int64_t timestampUs, bool isNoteChange) {
+    portENTER_CRITICAL(&gui_stats_mutex);
+    gui_stats.framesDrawn++;
+    is_note_change_pending |= isNoteChange;
+    if (pending_flush_timestamp_us == 0) {
+        pending_flush_timestamp_us = timestampUs; // Keep the oldest undrawn result if LVGL hasn't flushed yet
+    }
+    portEXIT_CRITICAL(&gui_stats_mutex);
+}
+
+/// @brief Called by LVGL after each flush. Once the last area of a refresh is
+/// handed to the panel, the pending reading is on its way to the screen.
+static void gui_flush_finish_cb(lv_event_t *e) {
+    lv_display_t *display = (lv_display_t *)lv_event_get_target(e);
+    const lv_area_t *area = (const lv_area_t *)lv_event_get_param(e);
+    if (area != NULL) {
+        refresh_flush_bytes += lv_area_get_size(area) * lv_color_format_get_size(lv_display_get_color_format(display));
+    }
+    if (!lv_display_flush_is_last(display)) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&gui_stats_mutex);
+    gui_stats.refreshes++;
+    gui_stats.flushBytes += refresh_flush_bytes;
+    if (is_note_change_pending) {
+        gui_stats.noteChanges++;
+        gui_stats.noteChangeFlushBytes += refresh_flush_bytes;
+        is_note_change_pending = false;
+    }
+    refresh_flush_bytes = 0;
+    if (pending_flush_timestamp_us != 0) {
+        int64_t latency = now - pending_flush_timestamp_us;
+        gui_stats.latencySamples++;
+        gui_stats.latencyLastUs = latency;
+        gui_stats.latencyTotalUs += latency;
+        if (latency < gui_stats.latencyMinUs) {
+            gui_stats.latencyMinUs = latency;
+        }
+        if (latency > gui_stats.latencyMaxUs) {
+            gui_stats.latencyMaxUs = latency;
+        }
+        pending_flush_timestamp_us = 0;
+    }
+    portEXIT_CRITICAL(&gui_stats_mutex);
+}
+
+static void gui_stats_log_latency() {
+    static uint32_t last_logged_samples = 0;
+    TunerGUIStats stats;
+    tuner_gui_get_stats(&stats);
+    if (stats.latencySamples - last_logged_samples < TUNER_GUI_LATENCY_LOG_INTERVAL) {
+        return;
+    }
+    last_logged_samples = stats.latencySamples;
+    ESP_LOGI(TAG, "ADC to flush latency (ms): last %.1f, min %.1f, mean %.1f, max %.1f",
+             stats.latencyLastUs / 1000.0f,
+             stats.latencyMinUs / 1000.0f,
+             stats.latencyTotalUs / 1000.0f / stats.latencySamples,
+             stats.latencyMaxUs / 1000.0f);
+    if (stats.refreshes > 0 && stats.noteChanges > 0) {
+        ESP_LOGI(TAG, "Flushed bytes: %.0f per refresh, %.0f per note change (%lu changes)",
+                 (double)stats.flushBytes / stats.refreshes,
+                 (double)stats.noteChangeFlushBytes / stats.noteChanges,
+                 (unsigned long)stats.noteChanges);
+    }
 }
 
 void user_settings_updated() {
@@ -329,29 +467,7 @@ void create_settings_ui() {
 
 // Function to calculate the MIDI note number from frequency
 float midi_note_from_frequency(float freq) {
-    return 69 + 12 * log2(freq / A4_FREQ);
-}
-
-// Function to get pitch name and cents from MIDI note number
-TunerNoteName get_pitch_name_and_cents_from_frequency(float freq, float *cents) {
-    float midi_note = midi_note_from_frequency(freq);
-    int note_index = (int)fmod(midi_note, 12);
-    float fractional_note = midi_note - (int)midi_note;
-
-    *cents = (fractional_note * CENTS_PER_SEMITONE);
-    if (*cents >= CENTS_PER_SEMITONE / 2) {
-        // Adjust the note index so that it still shows the proper note
-        note_index++;
-        if (note_index >= 12) {
-            note_index = 0; // Overflow to the beginning of the note names
-        }
-        *cents -= CENTS_PER_SEMITONE; // Adjust to valid range
-    }
-
-    if (note_index > 12) { // safeguard to prevent crash of snprintf()
-        note_index = 0;
-    }
-    return (TunerNoteName)note_index;
+    return 69 + NumericPolicy::centsFromA4(freq) / CENTS_PER_SEMITONE;
 }
 
 void settings_button_cb(lv_event_t *e) {
@@ -21,7 +21,34 @@
 
 #include "tuner_controller.h"
 
+#include <stdint.h>
+
+/// @brief End-to-end display latency, measured from the ADC capture of the
+/// sample that completed a pitch reading to the end of the LVGL flush that
+/// first shows it. Also counts the pixel bytes sent to the display.
+typedef struct {
+    uint32_t    framesDrawn;        // Number of times a new pitch result was drawn
+    uint32_t    latencySamples;     // Number of latency measurements
+    int64_t     latencyLastUs;
+    int64_t     latencyMinUs;
+    int64_t     latencyMaxUs;
+    int64_t     latencyTotalUs;     // Divide by latencySamples for the mean
+    uint32_t    refreshes;          // Number of completed LVGL refreshes
+    uint64_t    flushBytes;         // Pixel bytes sent to the display by all of them
+    uint32_t    noteChanges;        // Refreshes that showed a different note
+    uint64_t    noteChangeFlushBytes; // Pixel bytes sent by those refreshes
+} TunerGUIStats;
+
 void tuner_gui_task_tuner_state_changed(TunerState old_state, TunerState new_state);
 void user_settings_updated();
 
+/// @brief Wakes the GUI task because a new pitch result was published.
+///
+/// Called by the pitch detector task. The GUI task only redraws the tuning UI
+/// when this is called (limited to TUNER_GUI_MAX_FPS).
+void tuner_gui_task_pitch_result_available();
+
+/// @brief Gets a snapshot of the GUI latency stats (thread safe).
+void tuner_gui_get_stats(TunerGUIStats *stats);
+
 #endif
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "needle_ruler.h"
+
+#define NEEDLE_RULER_TICK_COUNT (NEEDLE_RULER_TICKS_PER_SIDE * 2 + 1)
+
+typedef struct {
+    lv_area_t   area;       // Relative to the ruler's top left
+    lv_color_t  color;
+} NeedleRulerTick;
+
+typedef struct {
+    NeedleRulerTick ticks[NEEDLE_RULER_TICK_COUNT];
+    int32_t         indicator_x;    // From the center
+    bool            is_indicator_visible;
+} NeedleRuler;
+
+static void needle_ruler_draw_cb(lv_event_t *e);
+static void needle_ruler_delete_cb(lv_event_t *e);
+
+/// @brief A `width` x `height` rectangle centered `x` pixels from the middle
+/// of a `ruler_width` x `ruler_height` ruler.
+static lv_area_t needle_ruler_centered_area(int32_t ruler_width, int32_t ruler_height, int32_t x, int32_t width, int32_t height) {
+    lv_area_t area;
+    area.x1 = (ruler_width - width) / 2 + x;
+    area.y1 = (ruler_height - height) / 2;
+    area.x2 = area.x1 + width - 1;
+    area.y2 = area.y1 + height - 1;
+    return area;
+}
+
+/// @brief The indicator bar in screen coordinates.
+static lv_area_t needle_ruler_indicator_area(lv_obj_t *obj, int32_t indicator_x) {
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+    lv_area_t area = needle_ruler_centered_area(lv_area_get_width(&coords), lv_area_get_height(&coords),
+        indicator_x, NEEDLE_RULER_INDICATOR_WIDTH, NEEDLE_RULER_CENTER_HEIGHT);
+    lv_area_move(&area, coords.x1, coords.y1);
+    return area;
+}
+
+lv_obj_t *needle_ruler_create(lv_obj_t *parent, int32_t width, int32_t height) {
+    NeedleRuler *ruler = new NeedleRuler();
+    ruler->indicator_x = 0;
+    ruler->is_indicator_visible = false;
+
+    // Center line, then the lines on the left and right sides
+    const int32_t spacer_width = (width - (NEEDLE_RULER_TICK_COUNT * NEEDLE_RULER_LINE_WIDTH)) / (NEEDLE_RULER_TICK_COUNT + 1);
+    ruler->ticks[0].area = needle_ruler_centered_area(width, height, 0, NEEDLE_RULER_LINE_WIDTH, NEEDLE_RULER_CENTER_HEIGHT);
+    ruler->ticks[0].color = lv_color_hex(0x777777);
+    for (int i = 1; i <= NEEDLE_RULER_TICKS_PER_SIDE; i++) {
+        // Alternating heights that get shorter away from the center
+        int32_t line_height = ((i % 2 == 0) ? NEEDLE_RULER_TALL_HEIGHT : NEEDLE_RULER_SHORT_HEIGHT) - i;
+        lv_color_t color = lv_color_hex(i % 2 ? 0x777777 : 0x333333);
+        int32_t offset = (spacer_width + NEEDLE_RULER_LINE_WIDTH) * i;
+
+        NeedleRulerTick *left = &ruler->ticks[i * 2 - 1];
+        left->area = needle_ruler_centered_area(width, height, -offset, NEEDLE_RULER_LINE_WIDTH, line_height);
+        left->color = color;
+
+        NeedleRulerTick *right = &ruler->ticks[i * 2];
+        right->area = needle_ruler_centered_area(width, height, offset, NEEDLE_RULER_LINE_WIDTH, line_height);
+        right->color = color;
+    }
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(obj, width, height);
+    lv_obj_set_style_bg_color(obj, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(obj, LV_OPA_COVER, 0);
+    lv_obj_set_user_data(obj, ruler);
+    lv_obj_add_event_cb(obj, needle_ruler_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, needle_ruler_delete_cb, LV_EVENT_DELETE, NULL);
+    return obj;
+}
+
+void needle_ruler_set_indicator_x(void *obj, int32_t x) {
+    NeedleRuler *ruler = (NeedleRuler *)lv_obj_get_user_data((lv_obj_t *)obj);
+    if (x == ruler->indicator_x) {
+        return;
+    }
+    if (ruler->is_indicator_visible) {
+        lv_area_t old_area = needle_ruler_indicator_area((lv_obj_t *)obj, ruler->indicator_x);
+        lv_area_t new_area = needle_ruler_indicator_area((lv_obj_t *)obj, x);
+        lv_obj_invalidate_area((lv_obj_t *)obj, &old_area);
+        lv_obj_invalidate_area((lv_obj_t *)obj, &new_area);
+    }
+    ruler->indicator_x = x;
+}
+
+void needle_ruler_set_indicator_visible(lv_obj_t *obj, bool is_visible) {
+    NeedleRuler *ruler = (NeedleRuler *)lv_obj_get_user_data(obj);
+    if (is_visible == ruler->is_indicator_visible) {
+        return;
+    }
+    ruler->is_indicator_visible = is_visible;
+    lv_area_t area = needle_ruler_indicator_area(obj, ruler->indicator_x);
+    lv_obj_invalidate_area(obj, &area);
+}
+
+static void needle_ruler_draw_cb(lv_event_t *e) {
+    lv_obj_t *obj = (lv_obj_t *)lv_event_get_target(e);
+    NeedleRuler *ruler = (NeedleRuler *)lv_obj_get_user_data(obj);
+    lv_layer_t *layer = lv_event_get_layer(e);
+
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    for (int i = 0; i < NEEDLE_RULER_TICK_COUNT; i++) {
+        lv_area_t area = ruler->ticks[i].area;
+        lv_area_move(&area, coords.x1, coords.y1);
+        dsc.bg_color = ruler->ticks[i].color;
+        lv_draw_rect(layer, &dsc, &area);
+    }
+
+    if (ruler->is_indicator_visible) {
+        lv_area_t area = needle_ruler_indicator_area(obj, ruler->indicator_x);
+        dsc.bg_color = lv_color_hex(0xFF0000);
+        dsc.radius = NEEDLE_RULER_INDICATOR_WIDTH / 2;
+        lv_draw_rect(layer, &dsc, &area);
+    }
+}
+
+static void needle_ruler_delete_cb(lv_event_t *e) {
+    lv_obj_t *obj = (lv_obj_t *)lv_event_get_target(e);
+    delete (NeedleRuler *)lv_obj_get_user_data(obj);
+    lv_obj_set_user_data(obj, NULL);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * The needle UI's ruler (center line and tick marks) and its pitch indicator
+ * bar as one LVGL object.
+ *
+ * The tick rectangles are worked out once when the ruler is created and
+ * painted in one draw callback, instead of being an `lv_obj` each (with their
+ * own styles, layout, and hit-testing). The indicator bar is painted over
+ * them, and moving it only invalidates where it was and where it's going.
+ */
+
+#if !defined(TUNER_NEEDLE_RULER)
+#define TUNER_NEEDLE_RULER
+
+#include "lvgl.h"
+
+#define NEEDLE_RULER_TICKS_PER_SIDE     14
+#define NEEDLE_RULER_LINE_WIDTH         2
+#define NEEDLE_RULER_CENTER_HEIGHT      40  // Also the indicator bar's height
+#define NEEDLE_RULER_TALL_HEIGHT        30
+#define NEEDLE_RULER_SHORT_HEIGHT       20
+#define NEEDLE_RULER_INDICATOR_WIDTH    8
+
+/// @brief Create the ruler (indicator hidden).
+lv_obj_t *needle_ruler_create(lv_obj_t *parent, int32_t width, int32_t height);
+
+/// @brief Move the indicator bar.
+/// @param x Pixels from the center (negative is flat). Takes `void *` so it
+/// can be an `lv_anim_t` exec callback.
+void needle_ruler_set_indicator_x(void *ruler, int32_t x);
+
+void needle_ruler_set_indicator_visible(lv_obj_t *ruler, bool is_visible);
+
+#endif
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "note_glyph.h"
+
+LV_IMG_DECLARE(tuner_font_image_a)
+LV_IMG_DECLARE(tuner_font_image_b)
+LV_IMG_DECLARE(tuner_font_image_c)
+LV_IMG_DECLARE(tuner_font_image_d)
+LV_IMG_DECLARE(tuner_font_image_e)
+LV_IMG_DECLARE(tuner_font_image_f)
+LV_IMG_DECLARE(tuner_font_image_g)
+LV_IMG_DECLARE(tuner_font_image_none)
+LV_IMG_DECLARE(tuner_font_image_sharp)
+
+typedef struct {
+    const lv_image_dsc_t    *image;
+    lv_area_t               ink;        // Relative to the glyph's top left
+    bool                    isInkKnown;
+} NoteGlyph;
+
+typedef enum {
+    glyphA = 0,
+    glyphB,
+    glyphC,
+    glyphD,
+    glyphE,
+    glyphF,
+    glyphG,
+    glyphNone,
+    glyphSharp,
+    glyphCount,
+} NoteGlyphIndex;
+
+static NoteGlyph note_glyphs[glyphCount] = {
+    { &tuner_font_image_a, {}, false },
+    { &tuner_font_image_b, {}, false },
+    { &tuner_font_image_c, {}, false },
+    { &tuner_font_image_d, {}, false },
+    { &tuner_font_image_e, {}, false },
+    { &tuner_font_image_f, {}, false },
+    { &tuner_font_image_g, {}, false },
+    { &tuner_font_image_none, {}, false },
+    { &tuner_font_image_sharp, {}, false },
+};
+
+/// @brief Indexed by TunerNoteName.
+static const NoteGlyphIndex note_name_glyphs[] = {
+    glyphC, glyphC, glyphD, glyphD, glyphE, glyphF, glyphF, glyphG, glyphG, glyphA, glyphA, glyphB, glyphNone,
+};
+
+typedef struct {
+    NoteGlyphPart   part;
+    NoteGlyph       *glyph;     // NULL draws nothing
+    lv_opa_t        opa;
+    lv_color_t      color;
+} NoteGlyphView;
+
+static void note_glyph_draw_cb(lv_event_t *e);
+static void note_glyph_delete_cb(lv_event_t *e);
+
+/// @brief Returns the box around the glyph's non-transparent pixels (x1 > x2
+/// if there aren't any). Worked out once per glyph.
+static const lv_area_t *note_glyph_get_ink(NoteGlyph *glyph) {
+    if (glyph->isInkKnown) {
+        return &glyph->ink;
+    }
+    const lv_image_header_t *header = &glyph->image->header;
+    lv_area_set(&glyph->ink, header->w, header->h, -1, -1);
+    for (int32_t y = 0; y < header->h; y++) {
+        const uint8_t *row = glyph->image->data + y * header->stride;
+        for (int32_t x = 0; x < header->w; x++) {
+            if (row[x] == 0) {
+                continue;
+            }
+            glyph->ink.x1 = LV_MIN(glyph->ink.x1, x);
+            glyph->ink.x2 = LV_MAX(glyph->ink.x2, x);
+            glyph->ink.y1 = LV_MIN(glyph->ink.y1, y);
+            glyph->ink.y2 = LV_MAX(glyph->ink.y2, y);
+        }
+    }
+    glyph->isInkKnown = true;
+    return &glyph->ink;
+}
+
+/// @brief Adds the glyph's ink (in screen coordinates) to `area`.
+static void note_glyph_add_ink(lv_obj_t *obj, NoteGlyph *glyph, lv_area_t *area, bool *has_area) {
+    if (glyph == NULL) {
+        return;
+    }
+    lv_area_t ink = *note_glyph_get_ink(glyph);
+    if (ink.x1 > ink.x2) {
+        return; // Nothing to draw
+    }
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+    lv_area_move(&ink, coords.x1, coords.y1);
+    if (*has_area) {
+        lv_area_join(area, area, &ink);
+    } else {
+        *area = ink;
+        *has_area = true;
+    }
+}
+
+static void note_glyph_invalidate(lv_obj_t *obj, NoteGlyph *old_glyph, NoteGlyph *new_glyph) {
+    lv_area_t area;
+    bool has_area = false;
+    note_glyph_add_ink(obj, old_glyph, &area, &has_area);
+    note_glyph_add_ink(obj, new_glyph, &area, &has_area);
+    if (has_area) {
+        lv_obj_invalidate_area(obj, &area);
+    }
+}
+
+lv_obj_t *note_glyph_create(lv_obj_t *parent, NoteGlyphPart part) {
+    NoteGlyphView *view = new NoteGlyphView();
+    view->part = part;
+    view->glyph = part == noteGlyphName ? &note_glyphs[glyphNone] : NULL;
+    view->opa = LV_OPA_COVER;
+    view->color = lv_color_white();
+
+    const lv_image_dsc_t *frame = part == noteGlyphName ? &tuner_font_image_none : &tuner_font_image_sharp;
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(obj, frame->header.w, frame->header.h);
+    lv_obj_set_user_data(obj, view);
+    lv_obj_add_event_cb(obj, note_glyph_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, note_glyph_delete_cb, LV_EVENT_DELETE, NULL);
+    return obj;
+}
+
+void note_glyph_set_note(lv_obj_t *obj, TunerNoteName note) {
+    if (note < 0 || note > NOTE_NONE) {
+        return;
+    }
+    NoteGlyphView *view = (NoteGlyphView *)lv_obj_get_user_data(obj);
+    NoteGlyph *glyph;
+    if (view->part == noteGlyphName) {
+        glyph = &note_glyphs[note_name_glyphs[note]];
+    } else {
+        bool is_sharp = note == NOTE_C_SHARP || note == NOTE_D_SHARP || note == NOTE_F_SHARP
+            || note == NOTE_G_SHARP || note == NOTE_A_SHARP;
+        glyph = is_sharp ? &note_glyphs[glyphSharp] : NULL;
+    }
+    if (glyph == view->glyph) {
+        return;
+    }
+    note_glyph_invalidate(obj, view->glyph, glyph);
+    view->glyph = glyph;
+}
+
+void note_glyph_set_opa(lv_obj_t *obj, lv_opa_t opa) {
+    NoteGlyphView *view = (NoteGlyphView *)lv_obj_get_user_data(obj);
+    if (opa == view->opa) {
+        return;
+    }
+    view->opa = opa;
+    note_glyph_invalidate(obj, view->glyph, NULL);
+}
+
+void note_glyph_set_palette(lv_obj_t *obj, lv_palette_t palette) {
+    NoteGlyphView *view = (NoteGlyphView *)lv_obj_get_user_data(obj);
+    view->color = palette == LV_PALETTE_NONE ? lv_color_white() : lv_palette_main(palette);
+    note_glyph_invalidate(obj, view->glyph, NULL);
+}
+
+static void note_glyph_draw_cb(lv_event_t *e) {
+    lv_obj_t *obj = (lv_obj_t *)lv_event_get_target(e);
+    NoteGlyphView *view = (NoteGlyphView *)lv_obj_get_user_data(obj);
+    if (view->glyph == NULL || view->opa <= LV_OPA_MIN) {
+        return;
+    }
+
+    // A8, so LVGL fills the glyph's coverage with the recolor directly
+    lv_draw_image_dsc_t dsc;
+    lv_draw_image_dsc_init(&dsc);
+    dsc.src = view->glyph->image;
+    dsc.recolor = view->color;
+    dsc.opa = view->opa;
+
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+    coords.x2 = coords.x1 + view->glyph->image->header.w - 1;
+    coords.y2 = coords.y1 + view->glyph->image->header.h - 1;
+    lv_draw_image(lv_event_get_layer(e), &dsc, &coords);
+}
+
+static void note_glyph_delete_cb(lv_event_t *e) {
+    lv_obj_t *obj = (lv_obj_t *)lv_event_get_target(e);
+    delete (NoteGlyphView *)lv_obj_get_user_data(obj);
+    lv_obj_set_user_data(obj, NULL);
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * The big note name (and sharp sign) the tuning UIs show.
+ *
+ * Swapping an `lv_image` source redraws the whole image, and fading a
+ * full-screen container redraws (and flushes) the whole screen. This object
+ * draws the A8 glyphs from main/fonts/tuner_note_glyph_atlas.c itself and only
+ * invalidates the pixels that can change: the union of the old and new
+ * glyph's ink (the box around its non-transparent pixels). Each glyph's ink
+ * box is worked out the first time it's shown and cached.
+ *
+ * The object is the size of the glyph frame (100x100 for a note name, 36x36
+ * for the sharp sign) so it can be aligned like the images were.
+ */
+
+#if !defined(TUNER_NOTE_GLYPH)
+#define TUNER_NOTE_GLYPH
+
+#include "globals.h"
+#include "lvgl.h"
+
+typedef enum {
+    noteGlyphName = 0,  // A-G, or "-" for NOTE_NONE
+    noteGlyphSharp,     // The sharp sign, or nothing for a natural note
+} NoteGlyphPart;
+
+/// @brief Create a note name or sharp sign object.
+lv_obj_t *note_glyph_create(lv_obj_t *parent, NoteGlyphPart part);
+
+/// @brief Show `note`. Only the ink of the old and new glyphs is redrawn, and
+/// nothing at all if the glyph doesn't change (C and C# share one).
+void note_glyph_set_note(lv_obj_t *obj, TunerNoteName note);
+
+/// @brief Fade the glyph without redrawing anything outside its ink.
+void note_glyph_set_opa(lv_obj_t *obj, lv_opa_t opa);
+
+/// @brief Tint the glyph with the palette's main color (white for LV_PALETTE_NONE).
+void note_glyph_set_palette(lv_obj_t *obj, lv_palette_t palette);
+
+#endif
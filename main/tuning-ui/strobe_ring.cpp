@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "strobe_ring.h"
+
+#include <cmath>
+#include <new>
+
+#define STROBE_RING_LIT_STEPS   (STROBE_RING_LIT_DEGREES * STROBE_RING_SEGMENTS * STROBE_RING_PHASE_STEPS / 360)
+#define STROBE_RING_EDGE_STEPS  2   // Anti-aliasing at each end of an arc (about 1.5px at a 100px radius)
+
+static_assert(STROBE_RING_PHASE_STEPS == 256, "Phase steps wrap as a uint8_t");
+
+typedef struct {
+    uint16_t    offset;     // First pixel in the buffer (so diameter <= 256)
+    uint16_t    length;
+} StrobeRingSpan;
+
+typedef struct {
+    lv_image_dsc_t  image;      // A8, diameter x diameter
+    uint8_t         *pixels;
+    StrobeRingSpan  *spans;     // Runs of ring pixels, top to bottom
+    size_t          span_count;
+    uint8_t         *angles;    // Each ring pixel's angle in phase steps (in span order)
+    uint8_t         *coverage;  // How much of each ring pixel is inside the band
+    size_t          pixel_count;
+    int32_t         phase;      // Phase step that's lit in `pixels`
+} StrobeRing;
+
+/// @brief How lit a pixel is by how many phase steps it is past the start of
+/// an arc.
+static uint8_t strobe_ring_lit_levels[STROBE_RING_PHASE_STEPS];
+
+static void strobe_ring_draw_cb(lv_event_t *e);
+static void strobe_ring_delete_cb(lv_event_t *e);
+
+static void strobe_ring_init_lit_levels() {
+    for (int step = 0; step < STROBE_RING_PHASE_STEPS; step++) {
+        int level = 0;
+        if (step < STROBE_RING_LIT_STEPS) {
+            int from_edge = LV_MIN(step, STROBE_RING_LIT_STEPS - 1 - step) + 1;
+            level = LV_MIN(from_edge * 255 / STROBE_RING_EDGE_STEPS, 255);
+        }
+        strobe_ring_lit_levels[step] = (uint8_t)level;
+    }
+}
+
+/// @brief Coverage (0 - 255) of the pixel at `x`, `y` (from the center) by a
+/// band from `inner` to `outer` radius.
+static uint8_t strobe_ring_pixel_coverage(float x, float y, float inner, float outer) {
+    float distance = sqrtf(x * x + y * y);
+    float coverage = fminf(fmaxf(outer - distance + 0.5f, 0.0f), 1.0f)
+        * fminf(fmaxf(distance - inner + 0.5f, 0.0f), 1.0f);
+    return (uint8_t)lroundf(coverage * 255);
+}
+
+static void strobe_ring_free(StrobeRing *ring) {
+    delete[] ring->pixels;
+    delete[] ring->spans;
+    delete[] ring->angles;
+    delete[] ring->coverage;
+    delete ring;
+}
+
+/// @brief Finds the ring's pixels and works out their coverage and angle.
+static bool strobe_ring_build(StrobeRing *ring, int32_t diameter, int32_t ring_width) {
+    const float outer = diameter / 2.0f;
+    const float inner = outer - ring_width;
+    const float center = diameter / 2.0f;
+
+    // Count first so each table is allocated once
+    for (int pass = 0; pass < 2; pass++) {
+        size_t span_count = 0;
+        size_t pixel_count = 0;
+        for (int32_t y = 0; y < diameter; y++) {
+            bool is_in_span = false;
+            for (int32_t x = 0; x < diameter; x++) {
+                float dx = x + 0.5f - center;
+                float dy = y + 0.5f - center;
+                uint8_t coverage = strobe_ring_pixel_coverage(dx, dy, inner, outer);
+                if (coverage == 0) {
+                    is_in_span = false;
+                    continue;
+                }
+                if (!is_in_span) {
+                    if (pass == 1) {
+                        ring->spans[span_count].offset = (uint16_t)(y * diameter + x);
+                        ring->spans[span_count].length = 0;
+                    }
+                    span_count++;
+                    is_in_span = true;
+                }
+                if (pass == 1) {
+                    // Clockwise from 3 o'clock, like lv_arc
+                    float degrees = atan2f(dy, dx) * 180.0f / (float)M_PI;
+                    int32_t step = (int32_t)floorf(degrees * STROBE_RING_SEGMENTS * STROBE_RING_PHASE_STEPS / 360.0f);
+                    ring->angles[pixel_count] = (uint8_t)(step & (STROBE_RING_PHASE_STEPS - 1));
+                    ring->coverage[pixel_count] = coverage;
+                    ring->spans[span_count - 1].length++;
+                }
+                pixel_count++;
+            }
+        }
+        if (pass == 0) {
+            ring->spans = new (std::nothrow) StrobeRingSpan[span_count];
+            ring->angles = new (std::nothrow) uint8_t[pixel_count];
+            ring->coverage = new (std::nothrow) uint8_t[pixel_count];
+            if (ring->spans == NULL || ring->angles == NULL || ring->coverage == NULL) {
+                return false;
+            }
+            ring->span_count = span_count;
+            ring->pixel_count = pixel_count;
+        }
+    }
+    return true;
+}
+
+/// @brief Light the ring pixels for `phase` (in phase steps).
+static void strobe_ring_render(StrobeRing *ring, uint8_t phase) {
+    const uint8_t *angle = ring->angles;
+    const uint8_t *coverage = ring->coverage;
+    for (size_t i = 0; i < ring->span_count; i++) {
+        uint8_t *pixel = ring->pixels + ring->spans[i].offset;
+        for (uint16_t j = 0; j < ring->spans[i].length; j++) {
+            uint8_t level = strobe_ring_lit_levels[(uint8_t)(*angle++ - phase)];
+            *pixel++ = (uint8_t)LV_UDIV255(*coverage++ * level);
+        }
+    }
+    ring->phase = phase;
+
+    // LVGL's image cache keeps a copy of A8 images keyed by the descriptor,
+    // so the copy has to go whenever the pixels change
+    lv_image_cache_drop(&ring->image);
+}
+
+lv_obj_t *strobe_ring_create(lv_obj_t *parent, int32_t diameter, int32_t ring_width) {
+    if (diameter <= 0 || diameter * diameter > UINT16_MAX + 1) {
+        return NULL; // Span offsets are 16 bits
+    }
+    if (strobe_ring_lit_levels[STROBE_RING_LIT_STEPS / 2] == 0) {
+        strobe_ring_init_lit_levels();
+    }
+
+    StrobeRing *ring = new StrobeRing();
+    ring->pixels = new (std::nothrow) uint8_t[diameter * diameter]();
+    if (ring->pixels == NULL || !strobe_ring_build(ring, diameter, ring_width)) {
+        strobe_ring_free(ring);
+        return NULL;
+    }
+    ring->image.header.magic = LV_IMAGE_HEADER_MAGIC;
+    ring->image.header.cf = LV_COLOR_FORMAT_A8;
+    ring->image.header.w = diameter;
+    ring->image.header.h = diameter;
+    ring->image.header.stride = diameter;
+    ring->image.data_size = diameter * diameter;
+    ring->image.data = ring->pixels;
+    strobe_ring_render(ring, 0);
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(obj, diameter, diameter);
+    lv_obj_set_user_data(obj, ring);
+    lv_obj_add_event_cb(obj, strobe_ring_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, strobe_ring_delete_cb, LV_EVENT_DELETE, NULL);
+    return obj;
+}
+
+void strobe_ring_set_rotation(lv_obj_t *obj, float degrees) {
+    StrobeRing *ring = (StrobeRing *)lv_obj_get_user_data(obj);
+    int32_t phase = (int32_t)floorf(degrees * STROBE_RING_SEGMENTS * STROBE_RING_PHASE_STEPS / 360.0f) & (STROBE_RING_PHASE_STEPS - 1);
+    if (phase == ring->phase) {
+        return;
+    }
+    strobe_ring_render(ring, (uint8_t)phase);
+    lv_obj_invalidate(obj);
+}
+
+static void strobe_ring_draw_cb(lv_event_t *e) {
+    lv_obj_t *obj = (lv_obj_t *)lv_event_get_target(e);
+    StrobeRing *ring = (StrobeRing *)lv_obj_get_user_data(obj);
+
+    // A8, so LVGL fills the lit pixels with the recolor directly
+    lv_draw_image_dsc_t dsc;
+    lv_draw_image_dsc_init(&dsc);
+    dsc.src = &ring->image;
+    dsc.recolor = lv_color_white();
+
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+    lv_draw_image(lv_event_get_layer(e), &dsc, &coords);
+}
+
+static void strobe_ring_delete_cb(lv_event_t *e) {
+    lv_obj_t *obj = (lv_obj_t *)lv_event_get_target(e);
+    StrobeRing *ring = (StrobeRing *)lv_obj_get_user_data(obj);
+    lv_image_cache_drop(&ring->image);
+    strobe_ring_free(ring);
+    lv_obj_set_user_data(obj, NULL);
+}
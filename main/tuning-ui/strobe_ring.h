@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * The strobe UI's rotating ring: STROBE_RING_SEGMENTS arcs of
+ * STROBE_RING_LIT_DEGREES each, spaced evenly around the circle.
+ *
+ * Rotating an `lv_arc` makes LVGL work out the radius and angle masks of every
+ * pixel again. The ring's shape never changes, only which part of it is lit,
+ * so each ring pixel's coverage (anti-aliased at the inner and outer edge) and
+ * angle are worked out once when the ring is created, a row span at a time.
+ * Setting the rotation then relights those pixels into an A8 buffer with a
+ * table lookup each and invalidates only the ring's bounding box. Nothing is
+ * redrawn unless the rotation has moved by at least one of the
+ * STROBE_RING_PHASE_STEPS steps the pattern repeats over.
+ *
+ * The buffer and tables come from the heap (not LVGL's pool), about
+ * diameter^2 + 2 bytes per ring pixel, and are freed with the object.
+ */
+
+#if !defined(TUNER_STROBE_RING)
+#define TUNER_STROBE_RING
+
+#include "lvgl.h"
+
+#define STROBE_RING_SEGMENTS        3
+#define STROBE_RING_LIT_DEGREES     90
+#define STROBE_RING_PHASE_STEPS     256 // Per repeat of the pattern (360 / STROBE_RING_SEGMENTS degrees)
+
+/// @brief Create a ring of `diameter` with a band `ring_width` pixels wide.
+/// Returns NULL if there isn't enough memory for it or `diameter` is over 256.
+lv_obj_t *strobe_ring_create(lv_obj_t *parent, int32_t diameter, int32_t ring_width);
+
+/// @brief Rotate the ring clockwise (like `lv_arc_set_rotation()`).
+void strobe_ring_set_rotation(lv_obj_t *ring, float degrees);
+
+#endif
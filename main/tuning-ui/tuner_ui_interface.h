@@ -47,7 +47,10 @@ typedef struct {
     void (*init)(lv_obj_t *screen);
     
     /// @brief Display the frequency/note/cents/etc.
-    void (*display_frequency)(float frequency, TunerNoteName note_name, float cents);
+    ///
+    /// `timestampUs` is when the reading was captured (esp_timer time), for
+    /// UIs that animate in step with the detector.
+    void (*display_frequency)(float frequency, TunerNoteName note_name, float cents, int64_t timestampUs);
 
     /// @brief Perform any cleanup needed (this UI is being deactivated).
     ///
@@ -21,26 +21,16 @@
 #include <stdlib.h>
 
 #include "globals.h"
+#include "needle_ruler.h"
+#include "note_glyph.h"
 #include "user_settings.h"
 
 #include "esp_lvgl_port.h"
 
-#define PITCH_INDICATOR_BAR_WIDTH       8
-
 extern UserSettings *userSettings;
 extern lv_coord_t screen_width;
 extern lv_coord_t screen_height;
 
-LV_IMG_DECLARE(tuner_font_image_a)
-LV_IMG_DECLARE(tuner_font_image_b)
-LV_IMG_DECLARE(tuner_font_image_c)
-LV_IMG_DECLARE(tuner_font_image_d)
-LV_IMG_DECLARE(tuner_font_image_e)
-LV_IMG_DECLARE(tuner_font_image_f)
-LV_IMG_DECLARE(tuner_font_image_g)
-LV_IMG_DECLARE(tuner_font_image_none)
-LV_IMG_DECLARE(tuner_font_image_sharp)
-
 //
 // Function Definitions
 //
@@ -73,7 +63,7 @@ lv_style_t needle_frequency_label_style;
 lv_obj_t *needle_cents_label;
 lv_style_t needle_cents_label_style;
 
-lv_obj_t *needle_pitch_indicator_bar;
+lv_obj_t *needle_ruler; // The ruler and pitch indicator bar
 
 lv_anim_t *needle_last_note_anim = NULL;
 
@@ -92,7 +82,7 @@ void needle_gui_init(lv_obj_t *screen) {
     needle_create_labels(screen);
 }
 
-void needle_gui_display_frequency(float frequency, TunerNoteName note_name, float cents) {
+void needle_gui_display_frequency(float frequency, TunerNoteName note_name, float cents, int64_t timestampUs) {
     if (note_name < 0) { return; } // Strangely I'm sometimes seeing negative values. No idea how.
     if (note_name != NOTE_NONE) {
         lv_label_set_text_fmt(needle_frequency_label, "%.2f", frequency);
@@ -120,8 +110,8 @@ void needle_gui_display_frequency(float frequency, TunerNoteName note_name, floa
         lv_anim_set_values(&needle_pitch_animation, needle_last_pitch_indicator_pos, indicator_x_pos);
         needle_last_pitch_indicator_pos = indicator_x_pos;
 
-        // Make the two bars show up
-        lv_obj_clear_flag(needle_pitch_indicator_bar, LV_OBJ_FLAG_HIDDEN);
+        // Make the indicator bar show up
+        needle_ruler_set_indicator_visible(needle_ruler, true);
 
         lv_label_set_text_fmt(needle_cents_label, "%.1f", cents);
         lv_obj_clear_flag(needle_cents_label, LV_OBJ_FLAG_HIDDEN);
@@ -135,7 +125,7 @@ void needle_gui_display_frequency(float frequency, TunerNoteName note_name, floa
         }
 
         // Hide the indicator bar, frequency, and cents labels
-        lv_obj_add_flag(needle_pitch_indicator_bar, LV_OBJ_FLAG_HIDDEN);
+        needle_ruler_set_indicator_visible(needle_ruler, false);
         lv_obj_add_flag(needle_cents_label, LV_OBJ_FLAG_HIDDEN);
         lv_obj_add_flag(needle_frequency_label, LV_OBJ_FLAG_HIDDEN);
     }
@@ -147,12 +137,6 @@ void needle_gui_cleanup() {
 
 void needle_create_ruler(lv_obj_t * parent) {
     const int ruler_height = 50;     // Total height of the ruler
-    const int ruler_line_width = 2;  // Width of each ruler line
-    const int spacer_width = (screen_width - (29 * ruler_line_width)) / 30;      // Width between items
-    const int center_height = 40;    // Height of the center line
-    const int tall_height = 30;      // Height of taller side lines
-    const int short_height = 20;     // Height of shorter side lines
-    const int num_lines_side = 14;   // Number of lines on each side of the center
 
     const int cents_container_height = ruler_height + 28;
 
@@ -176,71 +160,20 @@ void needle_create_ruler(lv_obj_t * parent) {
     lv_obj_align(needle_cents_label, LV_ALIGN_BOTTOM_MID, 0, 0);
     lv_obj_add_flag(needle_cents_label, LV_OBJ_FLAG_HIDDEN);
 
-    // Create a container for the ruler
-    lv_obj_t * ruler_container = lv_obj_create(parent);
-    lv_obj_set_scrollbar_mode(ruler_container, LV_SCROLLBAR_MODE_OFF);
-    lv_obj_set_style_border_width(ruler_container, 0, LV_PART_MAIN);
-    lv_obj_set_size(ruler_container, screen_width, ruler_height);
-    lv_obj_set_style_bg_color(ruler_container, lv_color_hex(0x000000), 0);
-    lv_obj_set_style_bg_opa(ruler_container, LV_OPA_COVER, 0);
-    lv_obj_align(ruler_container, LV_ALIGN_TOP_MID, 0, 0);
-
-    // Center line
-    lv_obj_t * center_line = lv_obj_create(ruler_container);
-    lv_obj_set_size(center_line, ruler_line_width, center_height);
-    lv_obj_set_style_bg_color(center_line, lv_color_hex(0x777777), 0);
-    lv_obj_set_style_bg_opa(center_line, LV_OPA_COVER, 0);
-    lv_obj_align(center_line, LV_ALIGN_CENTER, 0, 0);
-
-    // Lines on the left and right sides
-    for (int i = 1; i <= num_lines_side; i++) {
-        // Calculate heights for alternating lines
-        int line_height = ((i % 2 == 0) ? tall_height : short_height) - i;
-        bool is_tall_height = i % 2;
-
-        // Left side line
-        lv_obj_t * left_line = lv_obj_create(ruler_container);
-        lv_obj_set_size(left_line, ruler_line_width, line_height);
-        lv_obj_set_style_bg_color(left_line, lv_color_hex(is_tall_height ? 0x777777 : 0x333333), 0);
-        lv_obj_set_style_bg_opa(left_line, LV_OPA_COVER, 0);
-        lv_obj_align(left_line, LV_ALIGN_CENTER, -(spacer_width + 2) * i, 0);
-
-        // Right side line
-        lv_obj_t * right_line = lv_obj_create(ruler_container);
-        lv_obj_set_size(right_line, ruler_line_width, line_height);
-        lv_obj_set_style_bg_color(right_line, lv_color_hex(is_tall_height ? 0x777777 : 0x333333), 0);
-        lv_obj_set_style_bg_opa(right_line, LV_OPA_COVER, 0);
-        lv_obj_align(right_line, LV_ALIGN_CENTER, (spacer_width + 2) * i, 0);
-    }
-
-    //
-    // Create the indicator bar. This is the bar
-    // that moves around during tuning.
-    lv_obj_t * rect = lv_obj_create(ruler_container);
-
-    // Set the rectangle's size and position
-    lv_obj_set_size(rect, PITCH_INDICATOR_BAR_WIDTH, center_height);
-    lv_obj_set_style_border_width(rect, 0, LV_PART_MAIN);
-    lv_obj_align(rect, LV_ALIGN_CENTER, 0, 0);
-
-    // Set the rectangle's style (optional)
-    lv_obj_set_style_bg_color(rect, lv_color_hex(0xFF0000), LV_PART_MAIN);
-
-    needle_pitch_indicator_bar = rect;
-
-    // Hide these bars initially
-    lv_obj_add_flag(needle_pitch_indicator_bar, LV_OBJ_FLAG_HIDDEN);
+    // The ruler and indicator bar are one object (see needle_ruler.h)
+    needle_ruler = needle_ruler_create(parent, screen_width, ruler_height);
+    lv_obj_align(needle_ruler, LV_ALIGN_TOP_MID, 0, 0);
 
     // Initialize the pitch animation
     lv_anim_init(&needle_pitch_animation);
-    lv_anim_set_exec_cb(&needle_pitch_animation, (lv_anim_exec_xcb_t) lv_obj_set_x);
-    lv_anim_set_var(&needle_pitch_animation, needle_pitch_indicator_bar);
+    lv_anim_set_exec_cb(&needle_pitch_animation, needle_ruler_set_indicator_x);
+    lv_anim_set_var(&needle_pitch_animation, needle_ruler);
     lv_anim_set_duration(&needle_pitch_animation, 150);
 }
 
 void needle_create_labels(lv_obj_t * parent) {
-    // Place the note name and # symbole in the same container so the opacity
-    // can be animated.
+    // Place the note name and # symbol in the same container so they're laid
+    // out together.
     needle_note_img_container = lv_obj_create(parent);
     lv_obj_set_size(needle_note_img_container, lv_pct(100), lv_pct(100));
     lv_obj_set_style_bg_opa(needle_note_img_container, LV_OPA_0, 0);
@@ -248,26 +181,14 @@ void needle_create_labels(lv_obj_t * parent) {
     lv_obj_set_scrollbar_mode(needle_note_img_container, LV_SCROLLBAR_MODE_OFF);
     lv_obj_center(needle_note_img_container);
 
-    needle_note_img = lv_image_create(needle_note_img_container);
-    lv_image_set_src(needle_note_img, &tuner_font_image_none);
+    needle_note_img = note_glyph_create(needle_note_img_container, noteGlyphName);
     lv_obj_align(needle_note_img, LV_ALIGN_CENTER, 0, 20); // Offset down by 20 pixels
 
-    needle_sharp_img = lv_image_create(needle_note_img_container);
-    lv_image_set_src(needle_sharp_img, &tuner_font_image_sharp);
+    needle_sharp_img = note_glyph_create(needle_note_img_container, noteGlyphSharp);
     lv_obj_align_to(needle_sharp_img, needle_note_img, LV_ALIGN_TOP_RIGHT, 20, -15);
-    lv_obj_add_flag(needle_sharp_img, LV_OBJ_FLAG_HIDDEN);
-    
-    // Enable recoloring on the images
-    lv_obj_set_style_img_recolor_opa(needle_note_img, LV_OPA_COVER, LV_PART_MAIN);
-    lv_obj_set_style_img_recolor_opa(needle_sharp_img, LV_OPA_COVER, LV_PART_MAIN);
-    lv_palette_t palette = userSettings->noteNamePalette;
-    if (palette == LV_PALETTE_NONE) {
-        lv_obj_set_style_img_recolor(needle_note_img, lv_color_white(), 0);
-        lv_obj_set_style_img_recolor(needle_sharp_img, lv_color_white(), 0);
-    } else {
-        lv_obj_set_style_img_recolor(needle_note_img, lv_palette_main(palette), 0);
-        lv_obj_set_style_img_recolor(needle_sharp_img, lv_palette_main(palette), 0);
-    }
+
+    note_glyph_set_palette(needle_note_img, userSettings->noteNamePalette);
+    note_glyph_set_palette(needle_sharp_img, userSettings->noteNamePalette);
 
     // Frequency Label (very bottom)
     needle_frequency_label = lv_label_create(parent);
@@ -284,64 +205,16 @@ void needle_create_labels(lv_obj_t * parent) {
 }
 
 void needle_update_note_name(TunerNoteName new_value) {
-    // Set the note name with a timer so it doesn't get
-    // set too often for LVGL. ADC makes it run SUPER
-    // fast and can crash the software.
-    const lv_image_dsc_t *img_desc;
-    bool show_sharp_symbol = false;
-    bool show_note_fade_anim = false;
-    switch (new_value) {
-    case NOTE_A_SHARP:
-        show_sharp_symbol = true;
-    case NOTE_A:
-        img_desc = &tuner_font_image_a;
-        break;
-    case NOTE_B:
-        img_desc = &tuner_font_image_b;
-        break;
-    case NOTE_C_SHARP:
-        show_sharp_symbol = true;
-    case NOTE_C:
-        img_desc = &tuner_font_image_c;
-        break;
-    case NOTE_D_SHARP:
-        show_sharp_symbol = true;
-    case NOTE_D:
-        img_desc = &tuner_font_image_d;
-        break;
-    case NOTE_E:
-        img_desc = &tuner_font_image_e;
-        break;
-    case NOTE_F_SHARP:
-        show_sharp_symbol = true;
-    case NOTE_F:
-        img_desc = &tuner_font_image_f;
-        break;
-    case NOTE_G_SHARP:
-        show_sharp_symbol = true;
-    case NOTE_G:
-        img_desc = &tuner_font_image_g;
-        break;
-    case NOTE_NONE:
-        show_note_fade_anim = true;
-        break;
-    default:
+    if (new_value == NOTE_NONE) {
+        needle_start_note_fade_animation();
         return;
     }
 
-    if (show_note_fade_anim) {
-        needle_start_note_fade_animation();
-    } else {
-        needle_stop_note_fade_animation();
-
-        if (show_sharp_symbol) {
-            lv_obj_clear_flag(needle_sharp_img, LV_OBJ_FLAG_HIDDEN);
-        } else {
-            lv_obj_add_flag(needle_sharp_img, LV_OBJ_FLAG_HIDDEN);
-        }
+    needle_stop_note_fade_animation();
 
-        lv_image_set_src(needle_note_img, img_desc);
-    }
+    // Only the ink of the old and new glyphs is redrawn
+    note_glyph_set_note(needle_note_img, new_value);
+    note_glyph_set_note(needle_sharp_img, new_value);
 }
 
 void needle_start_note_fade_animation() {
@@ -349,14 +222,15 @@ void needle_start_note_fade_animation() {
     lv_anim_init(needle_last_note_anim);
     lv_anim_set_exec_cb(needle_last_note_anim, (lv_anim_exec_xcb_t)needle_last_note_anim_cb);
     lv_anim_set_completed_cb(needle_last_note_anim, needle_last_note_anim_completed_cb);
-    lv_anim_set_var(needle_last_note_anim, needle_note_img_container);
+    lv_anim_set_var(needle_last_note_anim, needle_note_img);
     lv_anim_set_duration(needle_last_note_anim, LAST_NOTE_FADE_INTERVAL_MS);
     lv_anim_set_values(needle_last_note_anim, 100, 0); // Fade from 100% to 0% opacity
     lv_anim_start(needle_last_note_anim);
 }
 
 void needle_stop_note_fade_animation() {
-    lv_obj_set_style_opa(needle_note_img_container, LV_OPA_100, 0);
+    note_glyph_set_opa(needle_note_img, LV_OPA_100);
+    note_glyph_set_opa(needle_sharp_img, LV_OPA_100);
     if (needle_last_note_anim == NULL) {
         return;
     }
@@ -370,7 +244,8 @@ void needle_last_note_anim_cb(lv_obj_t *obj, int32_t value) {
         return;
     }
 
-    lv_obj_set_style_opa(obj, value, LV_PART_MAIN);
+    note_glyph_set_opa(obj, value);
+    note_glyph_set_opa(needle_sharp_img, value);
 
     lvgl_port_unlock();
 }
@@ -381,8 +256,8 @@ void needle_last_note_anim_completed_cb(lv_anim_t *) {
     }
     // The animation has completed so hide the note name and set
     // the opacity back to 100%.
-    lv_obj_add_flag(needle_sharp_img, LV_OBJ_FLAG_HIDDEN);
-    lv_image_set_src(needle_note_img, &tuner_font_image_none);
+    note_glyph_set_note(needle_sharp_img, NOTE_NONE);
+    note_glyph_set_note(needle_note_img, NOTE_NONE);
     needle_last_displayed_note = NOTE_NONE;
 
     needle_stop_note_fade_animation();
@@ -25,7 +25,7 @@
 uint8_t needle_gui_get_id();
 const char * needle_gui_get_name();
 void needle_gui_init(lv_obj_t *screen);
-void needle_gui_display_frequency(float frequency, TunerNoteName note_name, float cents);
+void needle_gui_display_frequency(float frequency, TunerNoteName note_name, float cents, int64_t timestampUs);
 void needle_gui_cleanup();
 
 #endif
@@ -18,6 +18,12 @@
  */
 #include "user_settings.h"
 
+#include <cmath>
+#include <cstdio>
+
+#include "detector_profiles.h"
+#include "pitch_detector_task.h"
+#include "reading_filters.hpp"
 #include "tuner_controller.h"
 #include "tuner_ui_interface.h"
 
@@ -30,6 +36,7 @@ extern size_t num_of_available_guis;
 #define MENU_BTN_TUNER              "Tuner"
 #define MENU_BTN_TUNER_MODE         "Mode"
 #define MENU_BTN_IN_TUNE_THRESHOLD  "In-Tune Threshold"
+#define MENU_BTN_SAMPLE_RATE        "Sample Rate"
 
 #define MENU_BTN_DISPLAY            "Display"
     #define MENU_BTN_BRIGHTNESS         "Brightness"
@@ -47,8 +54,12 @@ extern size_t num_of_available_guis;
 #define MENU_BTN_EXP_SMOOTHING      "Exp Smoothing"
 #define MENU_BTN_1EU_BETA           "1 EU Beta"
 #define MENU_BTN_1EU_FLTR_1ST       "1 EU 1st?"
-#define MENU_BTN_MOVING_AVG         "Moving Average"
+    #define MENU_BTN_1EU_THEN_EXP       "1 EU, then Exp"
+    #define MENU_BTN_EXP_THEN_1EU       "Exp, then 1 EU"
+#define MENU_BTN_READING_FILTER     "Reading Filter"
+#define MENU_BTN_FILTER_WINDOW      "Filter Window"
 #define MENU_BTN_NAME_DEBOUNCING    "Name Debouncing"
+#define MENU_BTN_CALIBRATE_CLOCK    "Calibrate Clock"
 
 #define MENU_BTN_ABOUT              "About"
     #define MENU_BTN_FACTORY_RESET      "Factory Reset"
@@ -65,16 +76,22 @@ extern size_t num_of_available_guis;
 #define SETTING_KEY_DISPLAY_ORIENTATION     "display_orient"
 #define SETTING_KEY_EXP_SMOOTHING           "exp_smoothing"
 #define SETTING_KEY_ONE_EU_BETA             "one_eu_beta"
-#define SETTING_KEY_NOTE_DEBOUNCE_INTERVAL  "note_debounce"
+#define SETTING_KEY_NOTE_DEBOUNCE_INTERVAL  "note_dbnc_ms"    // u16, since the menu goes up to 500 ms
+#define SETTING_KEY_OLD_NOTE_DEBOUNCE       "note_debounce"   // u8, which wrapped anything over 255 ms
 #define SETTING_KEY_USE_1EU_FILTER_FIRST    "oneEUFilter1st"
-// #define SETTING_KEY_MOVING_AVG_WINDOW_SIZE  "movingAvgWindow"
+#define SETTING_KEY_READING_FILTER          "reading_filter"
+#define SETTING_KEY_READING_FILTER_WINDOW   "rd_filter_win"
 #define SETTING_KEY_DISPLAY_BRIGHTNESS      "disp_brightness"
+#define SETTING_KEY_DETECTOR_PROFILE        "detector_prof"
+#define SETTING_KEY_CLOCK_CORRECTION        "clk_corr_%lu"    // Per sample rate, in millionths
+#define SETTING_KEY_OLD_CLOCK_CORRECTION    "clock_correct"   // One for every rate, which only held for the rate it was measured at
 
 /*
 
 SETTINGS
     Tuning
         [X] In Tune Width
+        [x] Sample Rate (detector profile)
         [x] Back - returns to the main menu
 
     Display Settings
@@ -86,8 +103,11 @@ SETTINGS
     Debug
         [x] Exp Smoothing
         [x] 1EU Beta
+        [x] 1EU 1st? (1EU then Exp, or Exp then 1EU)
         [x] Note Debouncing
-        [x] Moving Average Window Size
+        [x] Reading Filter (None, Moving Average, Median, Hampel)
+        [x] Filter Window
+        [x] Calibrate Clock (measure the ADC's real sample rate)
         [x] Back - returns to the main menu
 
     About
@@ -109,6 +129,8 @@ static void handleTunerModeSelected(lv_event_t *e);
 static void handleInTuneThresholdButtonClicked(lv_event_t *e);
 static void handleInTuneThresholdButtonValueClicked(lv_event_t *e);
 static void handleInTuneThresholdRoller(lv_event_t *e);
+static void handleSampleRateButtonClicked(lv_event_t *e);
+static void handleSampleRateSelected(lv_event_t *e);
 
 static void handleDisplayButtonClicked(lv_event_t *e);
 static void handleBrightnessButtonClicked(lv_event_t *e);
@@ -139,8 +161,12 @@ static void handleDebugButtonClicked(lv_event_t *e);
 static void handleExpSmoothingButtonClicked(lv_event_t *e);
 static void handle1EUBetaButtonClicked(lv_event_t *e);
 static void handle1EUFilterFirstButtonClicked(lv_event_t *e);
-// static void handleMovingAvgButtonClicked(lv_event_t *e);
+static void handle1EUFilterFirstSelected(lv_event_t *e);
+static void handleReadingFilterButtonClicked(lv_event_t *e);
+static void handleReadingFilterSelected(lv_event_t *e);
+static void handleFilterWindowButtonClicked(lv_event_t *e);
 static void handleNameDebouncingButtonClicked(lv_event_t *e);
+static void handleCalibrateClockButtonClicked(lv_event_t *e);
 
 static void handleAboutButtonClicked(lv_event_t *e);
 static void handleFactoryResetButtonClicked(lv_event_t *e);
@@ -158,6 +184,7 @@ void UserSettings::loadSettings() {
     nvs_open("settings", NVS_READWRITE, &nvsHandle);
 
     uint8_t value;
+    uint16_t value16;
     uint32_t value32;
 
     if (nvs_get_u8(nvsHandle, SETTINGS_INITIAL_SCREEN, &value) == ESP_OK) {
@@ -208,8 +235,15 @@ void UserSettings::loadSettings() {
         oneEUBeta = DEFAULT_ONE_EU_BETA;
     }
 
-    if (nvs_get_u8(nvsHandle, SETTING_KEY_NOTE_DEBOUNCE_INTERVAL, &value) == ESP_OK) {
-        noteDebounceInterval = (float)value;
+    // A value saved under the old u8 key may have wrapped, so anything outside
+    // of what the menu offers falls back to the default
+    value16 = 0;
+    if (nvs_get_u16(nvsHandle, SETTING_KEY_NOTE_DEBOUNCE_INTERVAL, &value16) != ESP_OK
+            && nvs_get_u8(nvsHandle, SETTING_KEY_OLD_NOTE_DEBOUNCE, &value) == ESP_OK) {
+        value16 = value;
+    }
+    if (value16 >= TUNER_NOTE_DEBOUNCE_MIN && value16 <= TUNER_NOTE_DEBOUNCE_MAX) {
+        noteDebounceInterval = (float)value16;
     } else {
         noteDebounceInterval = DEFAULT_NOTE_DEBOUNCE_INTERVAL;
     }
@@ -220,17 +254,41 @@ void UserSettings::loadSettings() {
         use1EUFilterFirst = DEFAULT_USE_1EU_FILTER_FIRST;
     }
 
-    // if (nvs_get_u32(nvsHandle, SETTING_KEY_MOVING_AVG_WINDOW_SIZE, &value32) == ESP_OK) {
-    //     movingAvgWindow = (float)value32;
-    // } else {
-    //     movingAvgWindow = DEFAULT_MOVING_AVG_WINDOW;
-    // }
+    if (nvs_get_u8(nvsHandle, SETTING_KEY_READING_FILTER, &value) == ESP_OK && value < readingFilterCount) {
+        readingFilterType = value;
+    } else {
+        readingFilterType = DEFAULT_READING_FILTER_TYPE;
+    }
+
+    if (nvs_get_u8(nvsHandle, SETTING_KEY_READING_FILTER_WINDOW, &value) == ESP_OK) {
+        readingFilterWindow = (float)value;
+    } else {
+        readingFilterWindow = DEFAULT_READING_FILTER_WINDOW;
+    }
 
     if (nvs_get_u8(nvsHandle, SETTING_KEY_DISPLAY_BRIGHTNESS, &value) == ESP_OK) {
         displayBrightness = ((float)value) * 0.01;
     } else {
         displayBrightness = DEFAULT_DISPLAY_BRIGHTNESS;
     }
+
+    if (nvs_get_u8(nvsHandle, SETTING_KEY_DETECTOR_PROFILE, &value) == ESP_OK && value < detectorProfileCount) {
+        detectorProfileIndex = value;
+    } else {
+        detectorProfileIndex = DEFAULT_DETECTOR_PROFILE_INDEX;
+    }
+
+    // Stored in millionths, keyed by sample rate
+    for (uint8_t i = 0; i < detectorProfileCount; i++) {
+        char key[NVS_KEY_NAME_MAX_SIZE];
+        snprintf(key, sizeof(key), SETTING_KEY_CLOCK_CORRECTION, (unsigned long)detector_profile_get(i)->sampleRate);
+        if (nvs_get_u32(nvsHandle, key, &value32) == ESP_OK
+                && value32 >= TUNER_CLOCK_CORRECTION_MIN * 1000000 && value32 <= TUNER_CLOCK_CORRECTION_MAX * 1000000) {
+            sampleClockCorrections[i] = ((float)value32) * 0.000001;
+        } else {
+            sampleClockCorrections[i] = DEFAULT_SAMPLE_CLOCK_CORRECTION;
+        }
+    }
 }
 
 void UserSettings::setIsShowingSettings(bool isShowing) {
@@ -258,9 +316,18 @@ bool UserSettings::isShowingSettings() {
     return isShowing;
 }
 
+uint32_t UserSettings::getSettingsGeneration() {
+    uint32_t generation = 0;
+    portENTER_CRITICAL(&settingsGeneration_mutex);
+    generation = settingsGeneration;
+    portEXIT_CRITICAL(&settingsGeneration_mutex);
+    return generation;
+}
+
 void UserSettings::saveSettings() {
     ESP_LOGI(TAG, "save settings");
     uint8_t value;
+    uint16_t value16;
     uint32_t value32;
 
     value = initialState;
@@ -287,22 +354,41 @@ void UserSettings::saveSettings() {
     value32 = (uint32_t)(oneEUBeta * 1000);
     nvs_set_u32(nvsHandle, SETTING_KEY_ONE_EU_BETA, value32);
 
-    value = (uint8_t)noteDebounceInterval;
-    nvs_set_u8(nvsHandle, SETTING_KEY_NOTE_DEBOUNCE_INTERVAL, value);
+    value16 = (uint16_t)noteDebounceInterval;
+    nvs_set_u16(nvsHandle, SETTING_KEY_NOTE_DEBOUNCE_INTERVAL, value16);
+    nvs_erase_key(nvsHandle, SETTING_KEY_OLD_NOTE_DEBOUNCE);
 
     value = (uint8_t)use1EUFilterFirst;
     nvs_set_u8(nvsHandle, SETTING_KEY_USE_1EU_FILTER_FIRST, value);
 
-    // value32 = (uint32_t)movingAvgWindow;
-    // nvs_set_u32(nvsHandle, SETTING_KEY_MOVING_AVG_WINDOW_SIZE, value32);
+    value = readingFilterType;
+    nvs_set_u8(nvsHandle, SETTING_KEY_READING_FILTER, value);
+
+    value = (uint8_t)readingFilterWindow;
+    nvs_set_u8(nvsHandle, SETTING_KEY_READING_FILTER_WINDOW, value);
 
     value = (uint8_t)(displayBrightness * 100);
     nvs_set_u8(nvsHandle, SETTING_KEY_DISPLAY_BRIGHTNESS, value);
 
+    value = detectorProfileIndex;
+    nvs_set_u8(nvsHandle, SETTING_KEY_DETECTOR_PROFILE, value);
+
+    for (uint8_t i = 0; i < detectorProfileCount; i++) {
+        char key[NVS_KEY_NAME_MAX_SIZE];
+        snprintf(key, sizeof(key), SETTING_KEY_CLOCK_CORRECTION, (unsigned long)detector_profile_get(i)->sampleRate);
+        value32 = (uint32_t)roundf(sampleClockCorrections[i] * 1000000);
+        nvs_set_u32(nvsHandle, key, value32);
+    }
+    nvs_erase_key(nvsHandle, SETTING_KEY_OLD_CLOCK_CORRECTION);
+
     nvs_commit(nvsHandle);
 
     ESP_LOGI(TAG, "Settings saved");
 
+    portENTER_CRITICAL(&settingsGeneration_mutex);
+    settingsGeneration++;
+    portEXIT_CRITICAL(&settingsGeneration_mutex);
+
     settingsChangedCallback();
 }
 
@@ -316,8 +402,12 @@ void UserSettings::restoreDefaultSettings() {
     oneEUBeta = DEFAULT_ONE_EU_BETA;
     noteDebounceInterval = DEFAULT_NOTE_DEBOUNCE_INTERVAL;
     use1EUFilterFirst = DEFAULT_USE_1EU_FILTER_FIRST;
-    // movingAvgWindow = DEFAULT_MOVING_AVG_WINDOW;
+    readingFilterType = DEFAULT_READING_FILTER_TYPE;
+    readingFilterWindow = DEFAULT_READING_FILTER_WINDOW;
     displayBrightness = DEFAULT_DISPLAY_BRIGHTNESS;
+    detectorProfileIndex = DEFAULT_DETECTOR_PROFILE_INDEX;
+    // sampleClockCorrections are left alone. They belong to the hardware,
+    // not the user.
 
     saveSettings();
 
@@ -742,12 +832,14 @@ static void handleTunerButtonClicked(lv_event_t *e) {
     const char *buttonNames[] = {
         MENU_BTN_TUNER_MODE,
         MENU_BTN_IN_TUNE_THRESHOLD,
+        MENU_BTN_SAMPLE_RATE,
     };
     lv_event_cb_t callbackFunctions[] = {
         handleTunerModeButtonClicked,
         handleInTuneThresholdButtonClicked,
+        handleSampleRateButtonClicked,
     };
-    settings->createMenu(buttonNames, NULL, NULL, callbackFunctions, 2);
+    settings->createMenu(buttonNames, NULL, NULL, callbackFunctions, 3);
 }
 
 static void handleTunerModeButtonClicked(lv_event_t *e) {
@@ -797,6 +889,50 @@ static void handleTunerModeSelected(lv_event_t *e) {
     }
 }
 
+static void handleSampleRateButtonClicked(lv_event_t *e) {
+    ESP_LOGI(TAG, "Sample rate button clicked");
+    UserSettings *settings;
+    if (!lvgl_port_lock(0)) {
+        return;
+    }
+    settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
+    lvgl_port_unlock();
+
+    const char *buttonNames[detectorProfileCount];
+    lv_event_cb_t callbackFunctions[detectorProfileCount];
+    for (int i = 0; i < detectorProfileCount; i++) {
+        buttonNames[i] = detector_profile_get(i)->name;
+        callbackFunctions[i] = handleSampleRateSelected;
+    }
+
+    settings->createMenu(buttonNames, NULL, NULL, callbackFunctions, detectorProfileCount);
+}
+
+static void handleSampleRateSelected(lv_event_t *e) {
+    ESP_LOGI(TAG, "Sample rate clicked");
+    UserSettings *settings;
+    if (!lvgl_port_lock(0)) {
+        return;
+    }
+    settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
+
+    // Determine which profile was selected by the name of the button selected
+    lv_obj_t *btn = (lv_obj_t *)lv_event_get_target(e);
+    lv_obj_t *label = lv_obj_get_child(btn, 0);
+    char *button_text = lv_label_get_text(label);
+
+    lvgl_port_unlock();
+
+    for (int i = 0; i < detectorProfileCount; i++) {
+        if (strcmp(detector_profile_get(i)->name, button_text) == 0) {
+            // The detector task picks this up when the menu closes
+            settings->detectorProfileIndex = i;
+            settings->removeCurrentMenu(); // Don't make the user click back
+            return;
+        }
+    }
+}
+
 static void handleInTuneThresholdButtonClicked(lv_event_t *e) {
     ESP_LOGI(TAG, "In Tune Threshold button clicked");
     UserSettings *settings;
@@ -1125,16 +1261,22 @@ static void handleDebugButtonClicked(lv_event_t *e) {
     const char *buttonNames[] = {
         MENU_BTN_EXP_SMOOTHING,
         MENU_BTN_1EU_BETA,
+        MENU_BTN_1EU_FLTR_1ST,
         MENU_BTN_NAME_DEBOUNCING,
-        // MENU_BTN_MOVING_AVG,
+        MENU_BTN_READING_FILTER,
+        MENU_BTN_FILTER_WINDOW,
+        MENU_BTN_CALIBRATE_CLOCK,
     };
     lv_event_cb_t callbackFunctions[] = {
         handleExpSmoothingButtonClicked,
         handle1EUBetaButtonClicked,
+        handle1EUFilterFirstButtonClicked,
         handleNameDebouncingButtonClicked,
-        // handleMovingAvgButtonClicked,
+        handleReadingFilterButtonClicked,
+        handleFilterWindowButtonClicked,
+        handleCalibrateClockButtonClicked,
     };
-    settings->createMenu(buttonNames, NULL, NULL, callbackFunctions, 3);
+    settings->createMenu(buttonNames, NULL, NULL, callbackFunctions, 7);
 }
 
 static void handleExpSmoothingButtonClicked(lv_event_t *e) {
@@ -1166,17 +1308,84 @@ static void handle1EUFilterFirstButtonClicked(lv_event_t *e) {
     settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
     lvgl_port_unlock();
 
+    const char *buttonNames[] = {
+        MENU_BTN_1EU_THEN_EXP,
+        MENU_BTN_EXP_THEN_1EU,
+    };
+    lv_event_cb_t callbackFunctions[] = {
+        handle1EUFilterFirstSelected,
+        handle1EUFilterFirstSelected,
+    };
+    settings->createMenu(buttonNames, NULL, NULL, callbackFunctions, 2);
+}
+
+static void handle1EUFilterFirstSelected(lv_event_t *e) {
+    UserSettings *settings;
+    if (!lvgl_port_lock(0)) {
+        return;
+    }
+    settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
+
+    lv_obj_t *btn = (lv_obj_t *)lv_event_get_target(e);
+    lv_obj_t *label = lv_obj_get_child(btn, 0);
+    char *button_text = lv_label_get_text(label);
+
+    lvgl_port_unlock();
+
+    settings->use1EUFilterFirst = strcmp(button_text, MENU_BTN_1EU_THEN_EXP) == 0;
+    settings->removeCurrentMenu(); // Don't make the user click back
+}
+
+static void handleReadingFilterButtonClicked(lv_event_t *e) {
+    UserSettings *settings;
+    if (!lvgl_port_lock(0)) {
+        return;
+    }
+    settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
+    lvgl_port_unlock();
+
+    const char *buttonNames[readingFilterCount];
+    lv_event_cb_t callbackFunctions[readingFilterCount];
+    for (int i = 0; i < readingFilterCount; i++) {
+        buttonNames[i] = reading_filter_names[i];
+        callbackFunctions[i] = handleReadingFilterSelected;
+    }
+
+    settings->createMenu(buttonNames, NULL, NULL, callbackFunctions, readingFilterCount);
+}
+
+static void handleReadingFilterSelected(lv_event_t *e) {
+    UserSettings *settings;
+    if (!lvgl_port_lock(0)) {
+        return;
+    }
+    settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
+
+    // Determine which filter was selected by the name of the button selected
+    lv_obj_t *btn = (lv_obj_t *)lv_event_get_target(e);
+    lv_obj_t *label = lv_obj_get_child(btn, 0);
+    char *button_text = lv_label_get_text(label);
+
+    lvgl_port_unlock();
+
+    for (int i = 0; i < readingFilterCount; i++) {
+        if (strcmp(reading_filter_names[i], button_text) == 0) {
+            settings->readingFilterType = i;
+            settings->removeCurrentMenu(); // Don't make the user click back
+            return;
+        }
+    }
 }
 
-// static void handleMovingAvgButtonClicked(lv_event_t *e) {
-//     UserSettings *settings;
-//     if (!lvgl_port_lock(0)) {
-//         return;
-//     }
-//     settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
-//     lvgl_port_unlock();
-//     settings->createSpinbox(MENU_BTN_MOVING_AVG, 1, 1000, 4, 4, &settings->movingAvgWindow, 1);
-// }
+static void handleFilterWindowButtonClicked(lv_event_t *e) {
+    UserSettings *settings;
+    if (!lvgl_port_lock(0)) {
+        return;
+    }
+    settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
+    lvgl_port_unlock();
+    settings->createSpinbox(MENU_BTN_FILTER_WINDOW, 1, TUNER_READING_FILTER_MAX_WINDOW, 2, 2, &settings->readingFilterWindow, 1);
+}
 
 static void handleNameDebouncingButtonClicked(lv_event_t *e) {
     UserSettings *settings;
@@ -1185,7 +1394,120 @@ static void handleNameDebouncingButtonClicked(lv_event_t *e) {
     }
     settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
     lvgl_port_unlock();
-    settings->createSpinbox(MENU_BTN_NAME_DEBOUNCING, 100, 500, 3, 3, &settings->noteDebounceInterval, 1);
+    settings->createSpinbox(MENU_BTN_NAME_DEBOUNCING, TUNER_NOTE_DEBOUNCE_MIN, TUNER_NOTE_DEBOUNCE_MAX, 3, 3, &settings->noteDebounceInterval, 1);
+}
+
+/// @brief What the Calibrate Clock message box needs between timer ticks.
+///
+/// Owned by the message box: it's freed (and the timer stopped) when the box
+/// is deleted, whether by a button or by leaving settings with it open.
+typedef struct {
+    UserSettings    *settings;
+    lv_obj_t        *mbox;
+    lv_obj_t        *label;
+    lv_obj_t        *retryButton;   // Only while a measurement has failed
+    lv_timer_t      *timer;
+    uint32_t        sampleRate;     // What the correction was measured at
+    float           correction;
+} ClockCalibrationView;
+
+static void handleClockCalibrationDeleted(lv_event_t *e) {
+    ClockCalibrationView *view = (ClockCalibrationView *)lv_event_get_user_data(e);
+    if (view->timer != NULL) {
+        lv_timer_delete(view->timer);
+    }
+    delete view;
+}
+
+static void handleClockCalibrationRetryClicked(lv_event_t *e) {
+    if (!lvgl_port_lock(0)) {
+        return;
+    }
+    ClockCalibrationView *view = (ClockCalibrationView *)lv_event_get_user_data(e);
+    lv_obj_delete_async(view->retryButton); // It's the one being clicked
+    view->retryButton = NULL;
+    lv_label_set_text(view->label, "Measuring the ADC's sample rate...");
+    pitch_detector_start_clock_calibration();
+    lv_timer_resume(view->timer);
+    lvgl_port_unlock();
+}
+
+static void handleClockCalibrationTimer(lv_timer_t *timer) {
+    ClockCalibrationView *view = (ClockCalibrationView *)lv_timer_get_user_data(timer);
+    ClockCalibration calibration;
+    pitch_detector_get_clock_calibration(&calibration);
+    if (!calibration.isComplete) {
+        lv_label_set_text_fmt(view->label, "Measuring the ADC's sample rate... %d%%", (int)(calibration.progress * 100));
+        return;
+    }
+
+    lv_timer_pause(timer);
+    if (calibration.correction < TUNER_CLOCK_CORRECTION_MIN || calibration.correction > TUNER_CLOCK_CORRECTION_MAX) {
+        lv_label_set_text_fmt(view->label, "Measured %d Hz, which can't be right. Try again.", (int)calibration.measuredRate);
+        if (view->retryButton == NULL) {
+            view->retryButton = lv_msgbox_add_footer_button(view->mbox, "Retry");
+            lv_obj_add_event_cb(view->retryButton, handleClockCalibrationRetryClicked, LV_EVENT_CLICKED, view);
+        }
+        return;
+    }
+    view->sampleRate = (uint32_t)calibration.nominalRate;
+    view->correction = calibration.correction;
+    float savedCorrection = DEFAULT_SAMPLE_CLOCK_CORRECTION;
+    for (uint8_t i = 0; i < detectorProfileCount; i++) {
+        if (detector_profile_get(i)->sampleRate == view->sampleRate) {
+            savedCorrection = view->settings->sampleClockCorrections[i];
+        }
+    }
+    lv_label_set_text_fmt(view->label, "Asked for %d Hz, measured %d Hz.\nCorrection: %.5f (was %.5f)",
+        (int)calibration.nominalRate, (int)calibration.measuredRate, calibration.correction, savedCorrection);
+
+    lv_obj_t *btn = lv_msgbox_add_footer_button(view->mbox, "Save");
+    lv_obj_add_event_cb(btn, [](lv_event_t *e) {
+        if (!lvgl_port_lock(0)) {
+            return;
+        }
+        ClockCalibrationView *view = (ClockCalibrationView *)lv_event_get_user_data(e);
+        UserSettings *settings = view->settings;
+        // Only the profiles at the rate it was measured at
+        for (uint8_t i = 0; i < detectorProfileCount; i++) {
+            if (detector_profile_get(i)->sampleRate == view->sampleRate) {
+                settings->sampleClockCorrections[i] = view->correction;
+            }
+        }
+        lv_obj_del(view->mbox); // Frees the view
+        lvgl_port_unlock();
+        settings->saveSettings(); // The detector rebuilds its pipeline with it
+    }, LV_EVENT_CLICKED, view);
+}
+
+static void handleCalibrateClockButtonClicked(lv_event_t *e) {
+    UserSettings *settings;
+    if (!lvgl_port_lock(0)) {
+        return;
+    }
+    settings = (UserSettings *)lv_obj_get_user_data((lv_obj_t *)lv_event_get_target(e));
+
+    ClockCalibrationView *view = new ClockCalibrationView();
+    view->settings = settings;
+    view->mbox = lv_msgbox_create(lv_scr_act());
+    lv_obj_set_style_pad_all(view->mbox, 10, 0);
+    lv_msgbox_add_title(view->mbox, MENU_BTN_CALIBRATE_CLOCK);
+    view->label = lv_msgbox_add_text(view->mbox, "Measuring the ADC's sample rate...");
+    lv_obj_t *btn = lv_msgbox_add_footer_button(view->mbox, "Cancel");
+    lv_obj_add_event_cb(btn, [](lv_event_t *e) {
+        if (!lvgl_port_lock(0)) {
+            return;
+        }
+        lv_obj_del(((ClockCalibrationView *)lv_event_get_user_data(e))->mbox); // Frees the view
+        lvgl_port_unlock();
+    }, LV_EVENT_CLICKED, view);
+    lv_obj_center(view->mbox);
+
+    pitch_detector_start_clock_calibration();
+    view->timer = lv_timer_create(handleClockCalibrationTimer, 250, view);
+    lv_obj_add_event_cb(view->mbox, handleClockCalibrationDeleted, LV_EVENT_DELETE, view);
+
+    lvgl_port_unlock();
 }
 
 static void handleAboutButtonClicked(lv_event_t *e) {
@@ -38,6 +38,7 @@ extern "C" { // because these files are C and not C++
 #include "nvs.h"
 
 #include "defines.h"
+#include "detector_profiles.h"
 
 enum TunerOrientation: uint8_t {
     orientationNormal,
@@ -66,6 +67,8 @@ class UserSettings {
 
     nvs_handle_t    nvsHandle;
     bool isShowingMenu = false;
+    uint32_t settingsGeneration = 0;
+    portMUX_TYPE settingsGeneration_mutex = portMUX_INITIALIZER_UNLOCKED;
 
     settings_will_show_cb_t settingsWillShowCallback;
     settings_changed_cb_t settingsChangedCallback;
@@ -92,7 +95,10 @@ public:
     float               oneEUBeta               = DEFAULT_ONE_EU_BETA;
     float               noteDebounceInterval    = DEFAULT_NOTE_DEBOUNCE_INTERVAL;
     bool                use1EUFilterFirst       = DEFAULT_USE_1EU_FILTER_FIRST;
-//    float               movingAvgWindow         = DEFAULT_MOVING_AVG_WINDOW;
+    uint8_t             detectorProfileIndex    = DEFAULT_DETECTOR_PROFILE_INDEX; // A DetectorProfileIndex (see detector_profiles.h)
+    uint8_t             readingFilterType       = DEFAULT_READING_FILTER_TYPE; // A ReadingFilterType (see reading_filters.hpp)
+    float               readingFilterWindow     = DEFAULT_READING_FILTER_WINDOW;
+    float               sampleClockCorrections[detectorProfileCount]; // Per profile, measured per device by Calibrate Clock at the profile's sample rate
 
     /**
      * @brief Create the settings object and sets its parameters
@@ -109,6 +115,10 @@ public:
      */
     void saveSettings();
 
+    /// @brief Changes every time the settings are saved (thread safe), so other
+    /// tasks can rebuild what they derive from the settings only when needed.
+    uint32_t getSettingsGeneration();
+
     void restoreDefaultSettings();
     
     /**
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Header-only 1EU filter (same math as the original OneEuroFilter.cpp, which
+ * tools/pitch-bench keeps as its reference) that caches everything that only
+ * depends on the time between readings.
+ *
+ * Readings are timed by sample index instead of seconds. The detector reports
+ * once per period, so while a note holds steady the gap between readings is
+ * the same number of samples over and over. When it is, the rate and the
+ * derivative cutoff's alpha are reused and only the dynamic cutoff's alpha is
+ * worked out (one multiply and one divide instead of `alpha()`'s three
+ * divides, twice).
+ *
+ * `T` is the value type: `float`, `double`, or `q16_t` (Q16.16 fixed point,
+ * see fixed_point.hpp). Use `NumericPolicy::value_t` to follow
+ * TUNER_NUMERIC_POLICY.
+ *
+ * No ESP-IDF dependencies so tools/pitch-bench can use it too.
+ */
+
+#if !defined(TUNER_CACHED_ONE_EURO_FILTER)
+#define TUNER_CACHED_ONE_EURO_FILTER
+
+#include <cmath>
+#include <cstdint>
+
+#include "fixed_point.hpp"
+
+/// @brief Arithmetic for each value type. See the specializations below.
+template <typename T>
+struct OneEuroMath;
+
+/// @brief float and double share the same math.
+template <typename Real>
+struct OneEuroRealMath {
+    typedef Real    value_t;
+    typedef Real    coeff_t;
+    typedef Real    derivative_t;   // Value change per second
+    typedef Real    param_t;        // Cutoffs (Hz) and beta
+
+    /// @brief Terms that only depend on the time between readings.
+    typedef struct {
+        Real    twoPiTe;    // 2 * pi * seconds between readings
+        Real    rate;       // Readings per second
+    } Period;
+
+    static inline param_t cutoff(float hz) { return hz; }
+    static inline param_t beta(float beta) { return beta; }
+
+    static inline Period period(uint32_t samples, float sampleRate) {
+        Real te = samples / (Real)sampleRate;
+        Period p = { (Real)(2 * M_PI) * te, 1 / te };
+        return p;
+    }
+
+    /// @brief Same as `1 / (1 + tau / te)` with `tau = 1 / (2 * pi * cutoff)`.
+    static inline coeff_t alpha(const Period &p, param_t cutoff) {
+        Real x = cutoff * p.twoPiTe;
+        return x / (1 + x);
+    }
+
+    static inline derivative_t derivative(value_t delta, const Period &p) { return delta * p.rate; }
+
+    static inline param_t dynamicCutoff(param_t minCutoff, param_t beta, derivative_t dx) {
+        return minCutoff + beta * std::fabs(dx);
+    }
+
+    static inline value_t blend(value_t value, value_t previous, coeff_t alpha) {
+        return previous + alpha * (value - previous);
+    }
+
+    static inline derivative_t blendDerivative(derivative_t value, derivative_t previous, coeff_t alpha) {
+        return previous + alpha * (value - previous);
+    }
+};
+
+template <> struct OneEuroMath<float> : OneEuroRealMath<float> {};
+template <> struct OneEuroMath<double> : OneEuroRealMath<double> {};
+
+/// @brief Q16.16 values, Q15 alphas, and no floating point per reading.
+template <>
+struct OneEuroMath<q16_t> {
+    typedef q16_t   value_t;
+    typedef q15_t   coeff_t;
+    typedef int64_t derivative_t;   // Q16.16 Hz per second (can be well over 32767)
+    typedef int64_t param_t;        // Cutoffs are Q16.16, beta is Q24 (see `beta()`)
+
+    typedef struct {
+        int64_t     twoPiTe;        // Q32
+        uint32_t    samples;
+        uint32_t    sampleRate;
+    } Period;
+
+    static inline param_t cutoff(float hz) { return (param_t)(hz * Q16_ONE + 0.5f); }
+
+    // The user setting is small (0.003 by default) so Q16.16 would only keep
+    // two significant digits.
+    static inline param_t beta(float beta) { return (param_t)(beta * (1 << 24) + 0.5f); }
+
+    static inline Period period(uint32_t samples, float sampleRate) {
+        static const int64_t twoPiQ32 = (int64_t)(2 * M_PI * 4294967296.0);
+        uint32_t rate = (uint32_t)sampleRate;
+        Period p = { twoPiQ32 * samples / rate, samples, rate };
+        return p;
+    }
+
+    static inline coeff_t alpha(const Period &p, param_t cutoff) {
+        int64_t x = cutoff * p.twoPiTe; // Q48
+        int64_t alpha = x / (((1ll << 48) + x) >> 15);
+        return (coeff_t)(alpha > INT16_MAX ? INT16_MAX : alpha);
+    }
+
+    static inline derivative_t derivative(value_t delta, const Period &p) {
+        return (int64_t)delta * p.sampleRate / p.samples;
+    }
+
+    static inline param_t dynamicCutoff(param_t minCutoff, param_t beta, derivative_t dx) {
+        static const int64_t dxLimit = 1ll << 38; // Keeps `beta * dx` in 64 bits
+        int64_t magnitude = dx < 0 ? -dx : dx;
+        if (magnitude > dxLimit) {
+            magnitude = dxLimit;
+        }
+        static const int64_t cutoffLimit = 1ll << 30; // 16kHz, keeps `alpha()` in 64 bits
+        int64_t cutoff = minCutoff + ((beta * magnitude) >> 24);
+        return cutoff > cutoffLimit ? cutoffLimit : cutoff;
+    }
+
+    static inline value_t blend(value_t value, value_t previous, coeff_t alpha) {
+        return previous + q16_mul_q15(value - previous, alpha);
+    }
+
+    static inline derivative_t blendDerivative(derivative_t value, derivative_t previous, coeff_t alpha) {
+        return previous + (((value - previous) * alpha) >> 15);
+    }
+};
+
+/// @brief 1EU filter that only recomputes the dynamic cutoff term per reading.
+template <typename T>
+class CachedOneEuroFilter {
+    typedef OneEuroMath<T> Math;
+
+    float                           sampleRate;
+    typename Math::param_t          minCutoff;
+    typename Math::param_t          beta;
+    typename Math::param_t          derivativeCutoff;
+
+    // Cached for the last gap between readings
+    uint32_t                        periodSamples = 0;
+    typename Math::Period           period = {};
+    typename Math::coeff_t          derivativeAlpha = 0;
+
+    bool                            hasValue = false;
+    uint64_t                        lastSampleIndex = 0;
+    T                               value = 0;
+    typename Math::derivative_t     derivative = 0;
+
+public:
+
+    /// @param sampleRate Rate of the sample indices passed to `filter()`.
+    /// @param minCutoff Min cutoff frequency in Hz (> 0). Lower values remove more jitter.
+    /// @param beta Raise this to reduce lag when the value moves quickly.
+    /// @param derivativeCutoff Cutoff frequency in Hz used to smooth the derivative.
+    CachedOneEuroFilter(float sampleRate, float minCutoff, float beta, float derivativeCutoff) :
+        sampleRate(sampleRate),
+        minCutoff(Math::cutoff(minCutoff)),
+        beta(Math::beta(beta)),
+        derivativeCutoff(Math::cutoff(derivativeCutoff)) {}
+
+    void setBeta(float newBeta) { beta = Math::beta(newBeta); }
+
+    /// @brief Forget the last value so the next one passes straight through.
+    void reset() { hasValue = false; }
+
+    /// @brief Filter a reading.
+    /// @param newValue The reading.
+    /// @param sampleIndex Index of the sample the reading was taken at.
+    /// @return The filtered value.
+    inline T filter(T newValue, uint64_t sampleIndex) {
+        if (!hasValue) {
+            hasValue = true;
+            lastSampleIndex = sampleIndex;
+            value = newValue;
+            derivative = 0;
+            return value;
+        }
+
+        uint64_t elapsed = sampleIndex - lastSampleIndex;
+        lastSampleIndex = sampleIndex;
+        if (elapsed == 0) {
+            elapsed = 1;
+        }
+        if (elapsed != periodSamples) {
+            // Only happens when the time between readings changes
+            periodSamples = (uint32_t)elapsed;
+            period = Math::period(periodSamples, sampleRate);
+            derivativeAlpha = Math::alpha(period, derivativeCutoff);
+        }
+
+        derivative = Math::blendDerivative(Math::derivative(newValue - value, period), derivative, derivativeAlpha);
+        value = Math::blend(newValue, value, Math::alpha(period, Math::dynamicCutoff(minCutoff, beta, derivative)));
+        return value;
+    }
+};
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * A cheap counter for timing short stretches of code. On the ESP32 it's the
+ * CPU cycle counter. On the host (tools/pitch-bench) there's no portable cycle
+ * counter so it counts nanoseconds instead.
+ *
+ * The counter wraps, so only ever use the difference between two reads.
+ */
+
+#if !defined(TUNER_CYCLE_COUNTER)
+#define TUNER_CYCLE_COUNTER
+
+#include <cstdint>
+
+#if defined(ESP_PLATFORM)
+
+#include "esp_cpu.h"
+
+static inline uint32_t tuner_cycle_count() {
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+#define TUNER_CYCLE_COUNT_UNITS "cycles"
+
+#else
+
+#include <chrono>
+
+static inline uint32_t tuner_cycle_count() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#define TUNER_CYCLE_COUNT_UNITS "ns"
+
+#endif
+
+#endif
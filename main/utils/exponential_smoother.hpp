@@ -1,41 +1,56 @@
 #if !defined(TUNER_EXPONENTIAL_SMOOTHER)
 #define TUNER_EXPONENTIAL_SMOOTHER
 
-#include <vector>
 #include <algorithm>
 
+#include "numeric_policy.hpp"
+
+/// @brief Exponential moving average with O(1) state and no allocations.
+///
+/// `smoothed = amount * value + (1 - amount) * previousSmoothed`, so 1.0 is no
+/// smoothing and values near 0.0 smooth the most. The state is kept in the
+/// number format picked by TUNER_NUMERIC_POLICY.
 class ExponentialSmoother {
 public:
-    ExponentialSmoother(float amount) : amount(amount) {
-        amount = std::min(amount, 1.0f);
-        amount = std::max(amount, 0.0f);
+    ExponentialSmoother(float amount) {
+        setAmount(amount);
     }
 
     float smooth(float value) {
-        float newValue = value;
-        if (values.size() > 0) {
-            float last = values.back();
-            newValue = (amount * value) + (1.0 - amount) * last;
-            if (values.size() > 2) {
-                values.erase(values.begin()); // remove the first item
-            }
+        NumericPolicy::value_t input = NumericPolicy::fromHz(value);
+        if (hasValue) {
+            smoothed = NumericPolicy::blend(input, smoothed, alpha);
+        } else {
+            // The first value after a reset passes straight through
+            smoothed = input;
+            hasValue = true;
         }
-        values.push_back(value);
-        return newValue;
+        return NumericPolicy::toHz(smoothed);
     }
 
+    /// @brief Change the amount (0.0 - 1.0). Takes effect on the next value
+    /// without disturbing the current state, so it's safe to call every frame.
     void setAmount(float newAmount) {
-        amount = std::min(amount, 1.0f);
-        amount = std::max(amount, 0.0f);
+        newAmount = std::min(newAmount, 1.0f);
+        newAmount = std::max(newAmount, 0.0f);
+        if (newAmount == amount) {
+            return;
+        }
+        amount = newAmount;
+        alpha = NumericPolicy::coeff(amount);
     }
 
+    float getAmount() const { return amount; }
+
     void reset() {
-        (void)values.empty();
+        hasValue = false;
     }
 
 private:
-    std::vector<float> values;
-    float amount;
+    float amount = -1; // Forces the first setAmount() to store alpha
+    NumericPolicy::coeff_t alpha = 0;
+    NumericPolicy::value_t smoothed = 0;
+    bool hasValue = false;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Small fixed-point helpers for the pitch reading chain.
+ *
+ * - Q15 (int16_t) holds normalized samples and filter coefficients in [-1, 1).
+ * - Q16.16 (int32_t) holds frequencies and cents. Q31 can't, since anything
+ *   over 1.0 doesn't fit, and Q16.16 still resolves 0.000015 Hz up to 32kHz.
+ *
+ * Everything here is integer-only so it works the same on the host and on
+ * the ESP32 (which has a 32x32->64 multiplier but no double-precision FPU).
+ */
+
+#if !defined(TUNER_FIXED_POINT)
+#define TUNER_FIXED_POINT
+
+#include <cstdint>
+
+typedef int16_t q15_t;
+typedef int32_t q16_t;
+
+#define Q15_ONE     (1 << 15)
+#define Q16_ONE     (1 << 16)
+
+static inline q15_t q15_from_float(float value) {
+    float scaled = value * Q15_ONE;
+    if (scaled >= (float)INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (scaled <= (float)INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (q15_t)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f);
+}
+
+static inline float q15_to_float(q15_t value) {
+    return value * (1.0f / Q15_ONE);
+}
+
+static inline q16_t q16_from_float(float value) {
+    float scaled = value * Q16_ONE;
+    return (q16_t)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f);
+}
+
+static inline float q16_to_float(q16_t value) {
+    return value * (1.0f / Q16_ONE);
+}
+
+static inline q16_t q16_mul(q16_t a, q16_t b) {
+    return (q16_t)(((int64_t)a * b) >> 16);
+}
+
+/// @brief Scales a Q16.16 value by a Q15 coefficient.
+static inline q16_t q16_mul_q15(q16_t a, q15_t b) {
+    return (q16_t)(((int64_t)a * b) >> 15);
+}
+
+/// @brief log2 of a positive Q16.16 value, as Q16.16.
+///
+/// The integer part comes from the position of the top bit. The fraction is
+/// found one bit at a time by squaring the mantissa (16 multiplies), which is
+/// exact to the last bit of the result.
+static inline q16_t q16_log2(q16_t value) {
+    if (value <= 0) {
+        return INT32_MIN;
+    }
+    int msb = 31 - __builtin_clz((uint32_t)value);
+    q16_t result = (msb - 16) * Q16_ONE;
+
+    // Mantissa in [1, 2) as Q30
+    uint64_t mantissa = msb > 30 ? (uint64_t)value >> (msb - 30) : (uint64_t)value << (30 - msb);
+    for (int bit = 15; bit >= 0; bit--) {
+        mantissa = (mantissa * mantissa) >> 30;
+        if (mantissa >= (2ull << 30)) {
+            mantissa >>= 1;
+            result += 1 << bit;
+        }
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Note-change hysteresis for the tuning UIs.
+ *
+ * A reading close to the edge between two notes (or a wobble as a string is
+ * plucked) would otherwise flip the displayed note back and forth, and each
+ * flip swaps the big note name image, the most expensive thing the tuning UIs
+ * draw. A different note only replaces the committed one after it has been
+ * the nearest note for `UserSettings::noteDebounceInterval` milliseconds.
+ * Until then cents keep flowing relative to the committed note (pinned at
+ * +/- half a semitone).
+ *
+ * The first note after silence is committed straight away so it isn't
+ * delayed.
+ *
+ * No ESP-IDF dependencies.
+ */
+
+#if !defined(TUNER_NOTE_DEBOUNCER)
+#define TUNER_NOTE_DEBOUNCER
+
+#include <cmath>
+#include <cstdint>
+
+#include "defines.h"
+#include "globals.h"
+#include "numeric_policy.hpp"
+
+class NoteDebouncer {
+
+    bool        hasNote = false;
+    int         committedSemitones = 0; // From A4
+    bool        hasCandidate = false;
+    int         candidateSemitones = 0;
+    int64_t     candidateSinceUs = 0;
+
+    static TunerNoteName noteName(int semitonesFromA4) {
+        int noteIndex = (NOTE_A + semitonesFromA4) % 12;
+        if (noteIndex < 0) {
+            noteIndex += 12; // Below C4
+        }
+        return (TunerNoteName)noteIndex;
+    }
+
+public:
+
+    /// @brief Work out the note to show for a reading.
+    /// @param frequency The reading in Hz (> 0).
+    /// @param timeUs When the reading was captured (microseconds).
+    /// @param intervalMs How long a different note has to hold before it's shown.
+    /// @param cents Set to the cents away from the returned note.
+    /// @return The committed note.
+    TunerNoteName update(float frequency, int64_t timeUs, float intervalMs, float *cents) {
+        // The log2 is done in the number format picked by TUNER_NUMERIC_POLICY
+        float centsFromA4 = NumericPolicy::centsFromA4(frequency);
+
+        // Round to the nearest note (exactly half way rounds up)
+        int semitones = (int)floorf(centsFromA4 / CENTS_PER_SEMITONE + 0.5f);
+
+        if (!hasNote || semitones == committedSemitones) {
+            hasNote = true;
+            committedSemitones = semitones;
+            hasCandidate = false;
+        } else if (!hasCandidate || semitones != candidateSemitones) {
+            hasCandidate = true;
+            candidateSemitones = semitones;
+            candidateSinceUs = timeUs;
+        }
+
+        if (hasCandidate && timeUs - candidateSinceUs >= (int64_t)(intervalMs * 1000)) {
+            committedSemitones = candidateSemitones;
+            hasCandidate = false;
+        }
+
+        float offset = centsFromA4 - committedSemitones * CENTS_PER_SEMITONE;
+        const float limit = CENTS_PER_SEMITONE / 2.0f;
+        *cents = offset > limit ? limit : (offset < -limit ? -limit : offset);
+        return noteName(committedSemitones);
+    }
+
+    /// @brief Call when there's no signal so the next note shows right away.
+    void reset() {
+        hasNote = false;
+        hasCandidate = false;
+    }
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Compile-time choice of number format for the pitch reading chain:
+ * normalizing samples for the detector, smoothing readings, and working out
+ * cents. Set TUNER_NUMERIC_POLICY in defines.h.
+ *
+ * - TUNER_NUMERIC_FLOAT: single precision everywhere (the ESP32's FPU only
+ *   does single precision, so nothing falls back to software doubles).
+ * - TUNER_NUMERIC_FIXED: Q15 samples and coefficients, Q16.16 frequencies.
+ *
+ * q::pitch_detector only takes floats, so either way samples are handed to it
+ * as floats (`toDetector()`).
+ *
+ * No ESP-IDF dependencies so tools/pitch-bench can compare the two.
+ */
+
+#if !defined(TUNER_NUMERIC_POLICY_HPP)
+#define TUNER_NUMERIC_POLICY_HPP
+
+#include <cmath>
+#include <cstdint>
+
+#include "defines.h"
+#include "fixed_point.hpp"
+
+#define TUNER_NUMERIC_FLOAT     0
+#define TUNER_NUMERIC_FIXED     1
+
+/// @brief Single-precision float chain.
+struct FloatNumericPolicy {
+    typedef float   sample_t;   // A normalized sample (-1.0 to +1.0)
+    typedef float   value_t;    // A frequency in Hz
+    typedef float   coeff_t;    // A smoothing coefficient (0.0 - 1.0)
+
+    /// @brief Per-window normalization terms.
+    typedef struct {
+        float   center;
+        float   scale;
+    } Normalizer;
+
+    static constexpr const char *name = "float";
+
+    /// @param minValue Smallest sample in the window.
+    /// @param maxValue Largest sample in the window. If it isn't more than
+    /// `minValue`, every sample normalizes to 0.
+    static inline Normalizer normalizer(int32_t minValue, int32_t maxValue) {
+        if (maxValue <= minValue) {
+            Normalizer n = { (float)minValue, 0.0f };
+            return n;
+        }
+        float midVal = (maxValue - minValue) / 2.0f;
+        Normalizer n = { minValue + midVal, 1.0f / midVal };
+        return n;
+    }
+
+    static inline sample_t normalize(const Normalizer &n, int16_t sample) {
+        return (sample - n.center) * n.scale;
+    }
+
+    static inline float toDetector(sample_t sample) { return sample; }
+
+    static inline value_t fromHz(float frequency) { return frequency; }
+    static inline float toHz(value_t value) { return value; }
+    static inline coeff_t coeff(float amount) { return amount; }
+
+    /// @brief `alpha * value + (1 - alpha) * previous`
+    static inline value_t blend(value_t value, value_t previous, coeff_t alpha) {
+        return previous + alpha * (value - previous);
+    }
+
+    /// @brief Cents from A4 (A4_FREQ), so 100 per semitone and negative below A4.
+    static inline float centsFromA4(float frequency) {
+        return 1200.0f * log2f(frequency / (float)A4_FREQ);
+    }
+};
+
+/// @brief Q15/Q16.16 fixed-point chain.
+struct FixedNumericPolicy {
+    typedef q15_t   sample_t;
+    typedef q16_t   value_t;
+    typedef q15_t   coeff_t;
+
+    typedef struct {
+        int32_t sum;        // minValue + maxValue (twice the center, so it stays an integer)
+        int32_t reciprocal; // 2^31 / (maxValue - minValue)
+    } Normalizer;
+
+    static constexpr const char *name = "fixed";
+
+    /// @brief Same as FloatNumericPolicy::normalizer().
+    static inline Normalizer normalizer(int32_t minValue, int32_t maxValue) {
+        if (maxValue <= minValue) {
+            Normalizer n = { 2 * minValue, 0 };
+            return n;
+        }
+        Normalizer n = { minValue + maxValue, (int32_t)((1ll << 31) / (maxValue - minValue)) };
+        return n;
+    }
+
+    /// @brief `(2 * sample - sum) / range` in Q15, clamped to the Q15 range.
+    static inline sample_t normalize(const Normalizer &n, int16_t sample) {
+        int32_t value = (int32_t)(((int64_t)(2 * sample - n.sum) * n.reciprocal) >> 16);
+        if (value > INT16_MAX) {
+            return INT16_MAX;
+        }
+        if (value < INT16_MIN) {
+            return INT16_MIN;
+        }
+        return (sample_t)value;
+    }
+
+    static inline float toDetector(sample_t sample) { return q15_to_float(sample); }
+
+    static inline value_t fromHz(float frequency) { return q16_from_float(frequency); }
+    static inline float toHz(value_t value) { return q16_to_float(value); }
+    static inline coeff_t coeff(float amount) { return q15_from_float(amount); }
+
+    static inline value_t blend(value_t value, value_t previous, coeff_t alpha) {
+        return previous + q16_mul_q15(value - previous, alpha);
+    }
+
+    static inline float centsFromA4(float frequency) {
+        static const q16_t log2A4 = q16_log2(q16_from_float((float)A4_FREQ));
+        value_t value = fromHz(frequency);
+        if (value <= 0) {
+            return -INFINITY; // Same as log2f(0)
+        }
+        q16_t log2Ratio = q16_log2(value) - log2A4;
+        return q16_to_float(1200 * log2Ratio);
+    }
+};
+
+#if TUNER_NUMERIC_POLICY == TUNER_NUMERIC_FIXED
+typedef FixedNumericPolicy NumericPolicy;
+#else
+typedef FloatNumericPolicy NumericPolicy;
+#endif
+
+#endif
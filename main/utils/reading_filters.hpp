@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Sliding-window filters for detector readings (one value per detected
+ * period). All of them keep their window in a fixed-size ring, so nothing is
+ * allocated or shifted per reading:
+ *
+ * - MovingAverage: running sum, O(1) per reading (amortized).
+ * - RunningMedian: two heaps that share one array with the median in the
+ *   middle (max-heap below, min-heap above) plus a ring-to-heap index, so the
+ *   oldest value can be replaced in place. O(log window) per reading.
+ * - HampelFilter: replaces a reading with the window's median when it's more
+ *   than TUNER_HAMPEL_THRESHOLD scaled median absolute deviations away (an
+ *   octave jump or a glitch), otherwise passes it through.
+ *
+ * No ESP-IDF dependencies so tools/pitch-bench can use them too.
+ */
+
+#if !defined(TUNER_READING_FILTERS)
+#define TUNER_READING_FILTERS
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "defines.h"
+
+/// @brief The filter IDs. These are saved in NVS so don't reorder them.
+enum ReadingFilterType: uint8_t {
+    readingFilterNone = 0,
+    readingFilterMovingAverage,
+    readingFilterMedian,
+    readingFilterHampel,
+    readingFilterCount,
+};
+
+/// @brief Names shown in the settings menu, indexed by `ReadingFilterType`.
+static const char *const reading_filter_names[readingFilterCount] = {
+    "None",
+    "Moving Average",
+    "Median",
+    "Hampel",
+};
+
+/// @brief Clamps a requested window size to 1 ... TUNER_READING_FILTER_MAX_WINDOW.
+static inline size_t reading_filter_window(size_t windowSize) {
+    return std::max((size_t)1, std::min(windowSize, (size_t)TUNER_READING_FILTER_MAX_WINDOW));
+}
+
+class MovingAverage {
+public:
+    /// @brief Create a new moving average class with the specified window size.
+    /// @param windowSize Clamped to 1 ... TUNER_READING_FILTER_MAX_WINDOW.
+    explicit MovingAverage(size_t windowSize) {
+        setWindowSize(windowSize);
+    }
+
+    /// @brief Sets the window size. Starts the average over if it changed.
+    void setWindowSize(size_t newWindowSize) {
+        newWindowSize = reading_filter_window(newWindowSize);
+        if (newWindowSize != windowSize) {
+            windowSize = newWindowSize;
+            reset();
+        }
+    }
+
+    /// @brief Add a value to the averager.
+    /// @param value The new value.
+    /// @return Returns the current moving average.
+    float addValue(float value) {
+        if (count == windowSize) {
+            sum -= values[next]; // Drop the oldest
+        } else {
+            count++;
+        }
+        values[next] = value;
+        sum += value;
+        next = next + 1 == windowSize ? 0 : next + 1;
+        if (next == 0) {
+            // Re-add the window once per lap so float rounding can't build
+            // up over a long session (amortized O(1), no doubles on the ESP32)
+            sum = 0;
+            for (size_t i = 0; i < count; i++) {
+                sum += values[i];
+            }
+        }
+        return getAverage();
+    }
+
+    /// @brief Calculates the current moving average.
+    float getAverage() const {
+        if (count == 0) {
+            return 0.0f;
+        }
+        return sum / count;
+    }
+
+    /// @brief Resets the average and prep for reuse.
+    void reset() {
+        count = 0;
+        next = 0;
+        sum = 0;
+    }
+
+private:
+    float   values[TUNER_READING_FILTER_MAX_WINDOW];
+    size_t  windowSize = 0;
+    size_t  count = 0;
+    size_t  next = 0;   // Ring slot the next value goes in
+    float   sum = 0;
+};
+
+class RunningMedian {
+public:
+    explicit RunningMedian(size_t windowSize) {
+        setWindowSize(windowSize);
+    }
+
+    /// @brief Sets the window size. Starts over if it changed.
+    void setWindowSize(size_t newWindowSize) {
+        newWindowSize = reading_filter_window(newWindowSize);
+        if (newWindowSize != windowSize) {
+            windowSize = newWindowSize;
+            reset();
+        }
+    }
+
+    /// @brief Add a value (replacing the oldest once the window is full).
+    /// @return Returns the median of the window.
+    float addValue(float value) {
+        bool isNew = count < windowSize;
+        int p = pos[next];
+        float old = values[next];
+        values[next] = value;
+        next = next + 1 == windowSize ? 0 : next + 1;
+        count += isNew ? 1 : 0;
+
+        if (p > 0) {
+            // The slot is in the min-heap (above the median)
+            if (!isNew && old < value) {
+                minSortDown(p * 2);
+            } else if (minSortUp(p)) {
+                maxSortDown(-1);
+            }
+        } else if (p < 0) {
+            // The slot is in the max-heap (below the median)
+            if (!isNew && value < old) {
+                maxSortDown(p * 2);
+            } else if (maxSortUp(p)) {
+                minSortDown(1);
+            }
+        } else {
+            // The slot is the median
+            if (maxCount() > 0) {
+                maxSortDown(-1);
+            }
+            if (minCount() > 0) {
+                minSortDown(1);
+            }
+        }
+        return getMedian();
+    }
+
+    /// @brief The median (the mean of the middle two for an even count).
+    float getMedian() const {
+        if (count == 0) {
+            return 0.0f;
+        }
+        float median = values[heap()[0]];
+        if ((count & 1) == 0) {
+            median = (median + values[heap()[-1]]) / 2;
+        }
+        return median;
+    }
+
+    size_t getCount() const { return count; }
+
+    /// @brief Copies the values currently in the window (in no particular order).
+    /// @return The number of values copied (at most TUNER_READING_FILTER_MAX_WINDOW).
+    size_t copyValues(float *out) const {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = values[i];
+        }
+        return count;
+    }
+
+    void reset() {
+        count = 0;
+        next = 0;
+        // Lay the ring slots out alternately above and below the median
+        for (int i = (int)windowSize - 1; i >= 0; i--) {
+            pos[i] = ((i + 1) / 2) * ((i & 1) ? -1 : 1);
+            heap()[pos[i]] = i;
+        }
+    }
+
+private:
+    float   values[TUNER_READING_FILTER_MAX_WINDOW];
+    int     pos[TUNER_READING_FILTER_MAX_WINDOW];       // Ring slot -> heap index
+    int     heapStorage[TUNER_READING_FILTER_MAX_WINDOW]; // Heap index -> ring slot (see `heap()`)
+    size_t  windowSize = 0;
+    size_t  count = 0;
+    size_t  next = 0;
+
+    // Heap indices run from -maxCount() to +minCount() with the median at 0
+    int *heap() { return &heapStorage[windowSize / 2]; }
+    const int *heap() const { return &heapStorage[windowSize / 2]; }
+    int minCount() const { return ((int)count - 1) / 2; }
+    int maxCount() const { return (int)count / 2; }
+
+    bool isLess(int i, int j) { return values[heap()[i]] < values[heap()[j]]; }
+
+    bool exchange(int i, int j) {
+        int t = heap()[i];
+        heap()[i] = heap()[j];
+        heap()[j] = t;
+        pos[heap()[i]] = i;
+        pos[heap()[j]] = j;
+        return true;
+    }
+
+    /// @brief Swaps i and j if the value at i is less than the one at j.
+    bool compareExchange(int i, int j) { return isLess(i, j) && exchange(i, j); }
+
+    void minSortDown(int i) {
+        for (; i <= minCount(); i *= 2) {
+            if (i > 1 && i < minCount() && isLess(i + 1, i)) {
+                ++i;
+            }
+            if (!compareExchange(i, i / 2)) {
+                break;
+            }
+        }
+    }
+
+    void maxSortDown(int i) {
+        for (; i >= -maxCount(); i *= 2) {
+            if (i < -1 && i > -maxCount() && isLess(i, i - 1)) {
+                --i;
+            }
+            if (!compareExchange(i / 2, i)) {
+                break;
+            }
+        }
+    }
+
+    /// @return Returns true if the value moved all the way up to the median.
+    bool minSortUp(int i) {
+        while (i > 0 && compareExchange(i, i / 2)) {
+            i /= 2;
+        }
+        return i == 0;
+    }
+
+    bool maxSortUp(int i) {
+        while (i < 0 && compareExchange(i / 2, i)) {
+            i /= 2;
+        }
+        return i == 0;
+    }
+};
+
+class HampelFilter {
+public:
+    explicit HampelFilter(size_t windowSize) : median(windowSize) {}
+
+    void setWindowSize(size_t windowSize) { median.setWindowSize(windowSize); }
+
+    /// @brief Add a value.
+    /// @return Returns the value, or the window's median if the value is an outlier.
+    float addValue(float value) {
+        float windowMedian = median.addValue(value);
+
+        // Median absolute deviation of the window. The window is small (one
+        // value per detected period) so a partial sort of a copy is cheap.
+        size_t count = median.copyValues(deviations);
+        for (size_t i = 0; i < count; i++) {
+            deviations[i] = fabsf(deviations[i] - windowMedian);
+        }
+        std::nth_element(deviations, deviations + count / 2, deviations + count);
+        float mad = deviations[count / 2];
+
+        // 1.4826 makes the MAD comparable to a standard deviation
+        if (count >= 3 && fabsf(value - windowMedian) > TUNER_HAMPEL_THRESHOLD * 1.4826f * mad) {
+            return windowMedian;
+        }
+        return value;
+    }
+
+    void reset() { median.reset(); }
+
+private:
+    RunningMedian   median;
+    float           deviations[TUNER_READING_FILTER_MAX_WINDOW];
+};
+
+/// @brief One of the filters above, picked at runtime (from the Debug menu).
+class ReadingFilter {
+public:
+    ReadingFilter(uint8_t type, size_t windowSize) :
+        movingAverage(windowSize), median(windowSize), hampel(windowSize) {
+        configure(type, windowSize);
+    }
+
+    /// @brief Pick the filter and window. Cheap to call every frame; the
+    /// filters only start over when something changed.
+    void configure(uint8_t newType, size_t windowSize) {
+        if (newType >= readingFilterCount) {
+            newType = readingFilterNone;
+        }
+        if (newType != type) {
+            type = newType;
+            reset();
+        }
+        movingAverage.setWindowSize(windowSize);
+        median.setWindowSize(windowSize);
+        hampel.setWindowSize(windowSize);
+    }
+
+    float filter(float value) {
+        switch (type) {
+            case readingFilterMovingAverage:
+                return movingAverage.addValue(value);
+            case readingFilterMedian:
+                return median.addValue(value);
+            case readingFilterHampel:
+                return hampel.addValue(value);
+            default:
+                return value;
+        }
+    }
+
+    void reset() {
+        movingAverage.reset();
+        median.reset();
+        hampel.reset();
+    }
+
+private:
+    uint8_t         type = readingFilterCount; // Forces the first configure() to reset
+    MovingAverage   movingAverage;
+    RunningMedian   median;
+    HampelFilter    hampel;
+};
+
+#endif
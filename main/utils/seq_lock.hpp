@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#if !defined(TUNER_SEQ_LOCK)
+#define TUNER_SEQ_LOCK
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/// @brief Single-writer sequence lock for passing a small record between cores.
+///
+/// The writer never waits. Readers copy the record and retry if the writer
+/// was in the middle of an update, so neither side ever disables interrupts
+/// or blocks the other core. Only ONE task may call `write()`.
+///
+/// The record is stored as atomic 32-bit words (relaxed) so a torn read is
+/// detected by the sequence check instead of being a data race.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock records must be trivially copyable");
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "SeqLock records must be a multiple of 4 bytes");
+
+    static constexpr size_t wordCount = sizeof(T) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence{0};  // Odd while a write is in progress
+    std::atomic<uint32_t> words[wordCount];
+
+public:
+
+    SeqLock(const T &initial) {
+        uint32_t raw[wordCount];
+        memcpy(raw, &initial, sizeof(T));
+        for (size_t i = 0; i < wordCount; i++) {
+            words[i].store(raw[i], std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief Publish a new record. Only call this from one task.
+    void write(const T &value) {
+        uint32_t raw[wordCount];
+        memcpy(raw, &value, sizeof(T));
+
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < wordCount; i++) {
+            words[i].store(raw[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /// @brief Copy out a consistent snapshot of the latest record.
+    void read(T *value) const {
+        uint32_t raw[wordCount];
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < wordCount; i++) {
+                raw[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        memcpy(value, raw, sizeof(T));
+    }
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * The strobe UI's pattern phase, integrated over detector time.
+ *
+ * A mechanical strobe's disc turns at the reference pitch and is lit at the
+ * played pitch, so its pattern drifts by one band for every beat between the
+ * two: `frequency - reference` cycles a second. This does the same with the
+ * detector's readings. Each reading sets the beat frequency, and the phase
+ * advances by that beat times the time (from the readings' capture
+ * timestamps) until the next one. The display asks for the phase at its own
+ * "now" whenever it draws, so the motion doesn't depend on how often it draws
+ * or how often readings arrive.
+ *
+ * Between readings the phase keeps going at the last beat frequency. That's
+ * exactly what the next reading integrates, so a new reading changes the
+ * speed without making the pattern jump. A gap longer than `maxHoldUs` only
+ * counts as `maxHoldUs` so a stale reading doesn't keep the pattern turning.
+ *
+ * The phase is in pattern repeats (0.0 - 1.0). No ESP-IDF dependencies.
+ */
+
+#if !defined(TUNER_STROBE_PHASE_ENGINE)
+#define TUNER_STROBE_PHASE_ENGINE
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+class StrobePhaseEngine {
+
+    float       maxBeatHz;
+    int64_t     maxHoldUs;
+
+    float       phase = 0;          // At anchorUs
+    float       beatHz = 0;         // From anchorUs on
+    int64_t     anchorUs = 0;
+    bool        hasAnchor = false;
+
+    static float wrap(float cycles) {
+        return cycles - floorf(cycles);
+    }
+
+    float advance(int64_t timeUs) const {
+        int64_t elapsedUs = std::clamp(timeUs - anchorUs, (int64_t)0, maxHoldUs);
+        return wrap(phase + beatHz * (elapsedUs / 1000000.0f));
+    }
+
+public:
+
+    /// @param maxBeatHz The fastest the pattern may move (repeats a second).
+    /// Past about half the display's frame rate the motion aliases anyway.
+    /// @param maxHoldUs How long the pattern keeps moving without a reading.
+    StrobePhaseEngine(float maxBeatHz, int64_t maxHoldUs) : maxBeatHz(maxBeatHz), maxHoldUs(maxHoldUs) {}
+
+    /// @brief Add a reading.
+    /// @param frequency The reading in Hz (> 0).
+    /// @param cents How far the reading is from the note being tuned to.
+    /// Positive (sharp) moves the phase forward.
+    /// @param timeUs When the reading was captured (microseconds).
+    void update(float frequency, float cents, int64_t timeUs) {
+        if (hasAnchor && timeUs > anchorUs) {
+            phase = advance(timeUs);
+            anchorUs = timeUs;
+        } else if (!hasAnchor) {
+            anchorUs = timeUs;
+            hasAnchor = true;
+        }
+        // frequency - reference, without subtracting two nearly equal numbers
+        float beat = -frequency * expm1f(-cents * (float)M_LN2 / 1200.0f);
+        beatHz = std::clamp(beat, -maxBeatHz, maxBeatHz);
+    }
+
+    /// @brief Stop the pattern where it is at `timeUs` (no note is detected).
+    /// The next reading starts it again from there.
+    void stop(int64_t timeUs) {
+        if (hasAnchor) {
+            phase = advance(timeUs);
+        }
+        hasAnchor = false;
+        beatHz = 0;
+    }
+
+    /// @brief Returns the phase (0.0 - 1.0) at `timeUs`, which should be no
+    /// earlier than the last reading.
+    float getPhase(int64_t timeUs) const {
+        return hasAnchor ? advance(timeUs) : phase;
+    }
+
+    /// @brief Returns the beat frequency the pattern is moving at (Hz).
+    float getBeatHz() const {
+        return beatHz;
+    }
+};
+
+#endif
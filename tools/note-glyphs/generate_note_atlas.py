@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2024 Boyd Timothy. All rights reserved.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+
+"""
+Packs the note name glyphs into one A8 (alpha only) atlas for LVGL.
+
+The glyphs are drawn in a single colour (the "Note Color" setting), so all
+that matters in each pixel is its coverage. The source images are LVGL C
+image arrays (ARGB8888, as exported by LVGL's image converter). This keeps
+only their alpha channel and writes every glyph into one byte array with an
+`lv_image_dsc_t` per glyph pointing into it. The descriptor names are kept so
+the tuning UIs don't need to change which image they ask for.
+
+LVGL draws an A8 image as a mask filled with the draw descriptor's `recolor`
+colour. main/tuning-ui/note_glyph.cpp sets that from `noteNamePalette` when it
+draws a glyph, so there is no per-pixel recolour mix.
+
+Standard library only.
+
+    python3 tools/note-glyphs/generate_note_atlas.py            # regenerate
+    python3 tools/note-glyphs/generate_note_atlas.py --report   # print the size report too
+"""
+
+import argparse
+import os
+import re
+import sys
+
+REPO_ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+DEFAULT_SOURCE = os.path.join(REPO_ROOT, "tools", "note-glyphs", "tuner_font_images_argb8888.c")
+DEFAULT_OUTPUT = os.path.join(REPO_ROOT, "main", "fonts", "tuner_note_glyph_atlas.c")
+
+ATLAS_NAME = "tuner_note_glyph_atlas"
+DATA_ALIGN = 4          # CONFIG_LV_DRAW_BUF_ALIGN
+WHITE_MINIMUM = 240     # Any visible pixel darker than this isn't a plain tint mask
+BYTES_PER_LINE = 16
+
+BYTES_PER_PIXEL = {
+    "LV_COLOR_FORMAT_ARGB8888": 4,
+    "LV_COLOR_FORMAT_XRGB8888": 4,
+    "LV_COLOR_FORMAT_RGB888": 3,
+    "LV_COLOR_FORMAT_RGB565": 2,
+    "LV_COLOR_FORMAT_A8": 1,
+}
+
+# The glyphs a tuning UI shows at once: a note name and the sharp sign.
+FRAME_GLYPHS = ("tuner_font_image_a", "tuner_font_image_sharp")
+
+
+class Glyph:
+    def __init__(self, name, width, height, color_format, data):
+        self.name = name
+        self.width = width
+        self.height = height
+        self.color_format = color_format
+        self.data = data
+        self.alpha = None
+        self.offset = 0
+
+    @property
+    def source_size(self):
+        return self.width * self.height * BYTES_PER_PIXEL[self.color_format]
+
+    @property
+    def a8_size(self):
+        return self.width * self.height
+
+
+def parse_images(text):
+    """Returns every `lv_image_dsc_t` (and its `_map` array) in an LVGL C image file."""
+    glyphs = []
+    for match in re.finditer(r"uint8_t\s+(\w+)_map\[\]\s*=\s*\{(.*?)\};", text, re.S):
+        name = match.group(1)
+        data = bytes(int(value, 16) for value in re.findall(r"0x([0-9a-fA-F]{2})", match.group(2)))
+        descriptor = re.search(r"lv_image_dsc_t\s+" + name + r"\s*=\s*\{(.*?)\};", text, re.S)
+        if descriptor is None:
+            sys.exit("error: no lv_image_dsc_t for %s_map" % name)
+        fields = dict(re.findall(r"\.([\w.]+)\s*=\s*([^,]+),", descriptor.group(1)))
+        glyph = Glyph(name, int(fields["header.w"]), int(fields["header.h"]), fields["header.cf"].strip(), data)
+        if glyph.color_format not in ("LV_COLOR_FORMAT_ARGB8888", "LV_COLOR_FORMAT_A8"):
+            sys.exit("error: %s is %s, expected ARGB8888 or A8" % (name, glyph.color_format))
+        if len(data) != glyph.source_size:
+            sys.exit("error: %s has %d bytes, expected %d" % (name, len(data), glyph.source_size))
+        glyphs.append(glyph)
+    if not glyphs:
+        sys.exit("error: no images found")
+    return glyphs
+
+
+def extract_alpha(glyph):
+    """Keeps the coverage of a white-on-transparent glyph."""
+    if glyph.color_format == "LV_COLOR_FORMAT_A8":
+        return glyph.data
+    alpha = bytearray(glyph.width * glyph.height)
+    for i in range(len(alpha)):
+        blue, green, red, opacity = glyph.data[i * 4:i * 4 + 4]
+        if opacity and min(red, green, blue) < WHITE_MINIMUM:
+            sys.exit("error: %s has a coloured pixel at (%d, %d), so it can't be drawn as a tint mask"
+                     % (glyph.name, i % glyph.width, i // glyph.width))
+        alpha[i] = opacity
+    return bytes(alpha)
+
+
+def pack(glyphs):
+    """Lays the glyphs out one after another. Returns the atlas size."""
+    offset = 0
+    for glyph in glyphs:
+        glyph.alpha = extract_alpha(glyph)
+        glyph.offset = offset
+        offset += (glyph.a8_size + DATA_ALIGN - 1) // DATA_ALIGN * DATA_ALIGN
+    return offset
+
+
+def write_atlas(glyphs, atlas_size, source, output):
+    atlas = bytearray(atlas_size)
+    for glyph in glyphs:
+        atlas[glyph.offset:glyph.offset + glyph.a8_size] = glyph.alpha
+
+    lines = [
+        "/*",
+        " * Generated by tools/note-glyphs/generate_note_atlas.py from",
+        " * %s. Don't edit, regenerate." % os.path.relpath(source, REPO_ROOT),
+        " *",
+        " * Every note name glyph as alpha only (A8) in one array. LVGL fills A8",
+        " * images with the draw descriptor's recolor (see note_glyph_draw_cb()).",
+        " */",
+        "",
+        "#include \"lvgl.h\"",
+        "",
+        "#ifndef LV_ATTRIBUTE_MEM_ALIGN",
+        "#define LV_ATTRIBUTE_MEM_ALIGN",
+        "#endif",
+        "",
+        "const LV_ATTRIBUTE_MEM_ALIGN LV_ATTRIBUTE_LARGE_CONST uint8_t %s[%d] = {" % (ATLAS_NAME, atlas_size),
+    ]
+    glyph_at = {glyph.offset: glyph for glyph in glyphs}
+    for start in range(0, atlas_size, BYTES_PER_LINE):
+        if start in glyph_at:
+            glyph = glyph_at[start]
+            lines.append("  /* %s (%dx%d) */" % (glyph.name, glyph.width, glyph.height))
+        row = atlas[start:start + BYTES_PER_LINE]
+        lines.append("  " + ", ".join("0x%02x" % value for value in row) + ",")
+    lines.append("};")
+
+    for glyph in glyphs:
+        lines += [
+            "",
+            "const lv_image_dsc_t %s = {" % glyph.name,
+            "  .header.cf = LV_COLOR_FORMAT_A8,",
+            "  .header.magic = LV_IMAGE_HEADER_MAGIC,",
+            "  .header.w = %d," % glyph.width,
+            "  .header.h = %d," % glyph.height,
+            "  .header.stride = %d," % glyph.width,
+            "  .data_size = %d," % glyph.a8_size,
+            "  .data = %s + %d," % (ATLAS_NAME, glyph.offset),
+            "};",
+        ]
+
+    with open(output, "w") as file:
+        file.write("\n".join(lines) + "\n")
+
+
+def report(glyphs, atlas_size, source, output):
+    """Prints the before/after table in tools/note-glyphs/README.md."""
+    before = sum(glyph.source_size for glyph in glyphs)
+    print("| Glyph | Size | ARGB8888 (bytes) | A8 (bytes) |")
+    print("|---|---|---:|---:|")
+    for glyph in glyphs:
+        print("| `%s` | %dx%d | %d | %d |" % (glyph.name, glyph.width, glyph.height, glyph.source_size, glyph.a8_size))
+    print("| **Total (flash)** | | **%d** | **%d** |" % (before, atlas_size))
+    print()
+    print("Flash: %.1f KB -> %.1f KB (%.1fx smaller)." % (before / 1024, atlas_size / 1024, before / atlas_size))
+    print("C source: %.0f KB -> %.0f KB." % (os.path.getsize(source) / 1024, os.path.getsize(output) / 1024))
+
+    by_name = {glyph.name: glyph for glyph in glyphs}
+    shown = [by_name[name] for name in FRAME_GLYPHS if name in by_name]
+    pixels = sum(glyph.width * glyph.height for glyph in shown)
+    print()
+    print("Redrawing the note name and sharp sign (%d pixels):" % pixels)
+    print()
+    print("| | Image bytes read | Per pixel |")
+    print("|---|---:|---|")
+    print("| ARGB8888 + recolor | %d | read 4 bytes, mix with the recolour, alpha blend |"
+          % sum(glyph.source_size for glyph in shown))
+    print("| A8 | %d | read 1 byte, blend the fill colour by it |" % sum(glyph.a8_size for glyph in shown))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack the note name glyphs into one A8 atlas.")
+    parser.add_argument("--source", default=DEFAULT_SOURCE, help="LVGL C image file with the glyphs")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="Atlas C file to write")
+    parser.add_argument("--report", action="store_true", help="Print the before/after size report")
+    args = parser.parse_args()
+
+    with open(args.source) as file:
+        glyphs = parse_images(file.read())
+    atlas_size = pack(glyphs)
+    write_atlas(glyphs, atlas_size, args.source, args.output)
+    print("Wrote %d glyphs (%d bytes) to %s" % (len(glyphs), atlas_size, os.path.relpath(args.output, REPO_ROOT)))
+    if args.report:
+        print()
+        report(glyphs, atlas_size, args.source, args.output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "ground_truth.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+bool ground_truth_load(const std::string &path, std::vector<GroundTruthNote> *notes, std::string *error) {
+    std::ifstream file(path);
+    if (!file) {
+        *error = "unable to open label file " + path;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        std::replace(line.begin(), line.end(), ',', ' ');
+
+        GroundTruthNote note;
+        std::istringstream fields(line);
+        if (!(fields >> note.onsetSeconds >> note.endSeconds >> note.frequency)
+                || note.endSeconds <= note.onsetSeconds || note.frequency <= 0) {
+            *error = path + ":" + std::to_string(lineNumber) + ": expected onset_seconds,end_seconds,frequency_hz";
+            return false;
+        }
+        notes->push_back(note);
+    }
+
+    std::sort(notes->begin(), notes->end(), [](const GroundTruthNote &a, const GroundTruthNote &b) {
+        return a.onsetSeconds < b.onsetSeconds;
+    });
+    return true;
+}
+
+std::string ground_truth_path_for_wav(const std::string &wavPath) {
+    size_t dot = wavPath.find_last_of('.');
+    size_t slash = wavPath.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return wavPath + ".csv";
+    }
+    return wavPath.substr(0, dot) + ".csv";
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#if !defined(PITCH_BENCH_GROUND_TRUTH)
+#define PITCH_BENCH_GROUND_TRUTH
+
+#include <string>
+#include <vector>
+
+/// @brief One labelled note in a recording.
+typedef struct {
+    double  onsetSeconds;   // When the string is plucked
+    double  endSeconds;     // When the note has decayed (or the next note starts)
+    double  frequency;      // The true fundamental in Hz
+} GroundTruthNote;
+
+/// @brief Loads note labels for a recording.
+///
+/// The file is plain text with one note per line:
+///
+///     onset_seconds,end_seconds,frequency_hz
+///
+/// Blank lines and lines that start with `#` are ignored. Tabs or spaces may
+/// be used instead of commas, so Audacity label exports work if the label text
+/// is the frequency.
+///
+/// @return Returns `true` if the file was loaded.
+bool ground_truth_load(const std::string &path, std::vector<GroundTruthNote> *notes, std::string *error);
+
+/// @brief Returns the default label path for a WAV file (`guitar_e2.wav` > `guitar_e2.csv`).
+std::string ground_truth_path_for_wav(const std::string &wavPath);
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Microbenchmark for the ADC frame kernels in main/detector/adc_frame_kernels.h.
+ *
+ * Each variant takes one TUNER_ADC_FRAME_SIZE frame of type1 ADC words and
+ * produces the normalized (-1.0 to +1.0) samples that get handed to
+ * q::pitch_detector. The samples are summed instead of detected so that only
+ * the unpack/normalize cost is measured. The "rms" variants also work out the
+ * noise gate's RMS, from the fused kernel's sums or with a second pass over
+ * the samples.
+ */
+
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "defines.h"
+#include "adc_frame_kernels.h"
+
+#define KERNEL_BENCH_DEFAULT_FRAMES 200000
+
+/// @brief Same layout as ESP-IDF's `adc_digi_output_data_t::type1`.
+typedef struct {
+    uint16_t data:      12;
+    uint16_t channel:   4;
+} BenchAdcType1;
+
+static volatile float benchSink;
+
+/// @brief The loop `pitch_detector_task()` used before the fused kernel.
+///
+/// Pass one unpacks the bitfield into floats while tracking min/max. Pass two
+/// normalizes around the midpoint with a divide per sample.
+static float frame_two_pass(const uint8_t *adcBuffer, size_t numBytes, float *in) {
+    float maxVal = 0;
+    float minVal = FLT_MAX;
+    int valuesStored = 0;
+    for (size_t i = 0; i < numBytes; i += sizeof(uint16_t), valuesStored++) {
+        const BenchAdcType1 *p = (const BenchAdcType1 *)&adcBuffer[i];
+        in[valuesStored] = p->data;
+        if (in[valuesStored] > maxVal) {
+            maxVal = in[valuesStored];
+        }
+        if (in[valuesStored] < minVal) {
+            minVal = in[valuesStored];
+        }
+    }
+
+    float range = maxVal - minVal;
+    float midVal = range / 2;
+    float sum = 0;
+    for (int i = 0; i < valuesStored; i++) {
+        float newPosition = in[i] - midVal - minVal;
+        in[i] = newPosition / midVal;
+        sum += in[i];
+    }
+    return sum;
+}
+
+/// @brief `adc_unpack_frame_int16()` and the multiply `PitchPipeline` does while feeding the detector.
+static float frame_fused_int16(const uint8_t *adcBuffer, size_t numBytes, int16_t *samples) {
+    size_t count = numBytes / sizeof(uint16_t);
+    AdcFrameRange frameRange = adc_unpack_frame_int16((const uint16_t *)adcBuffer, count, samples);
+
+    float midVal = adc_frame_range_peak_to_peak(frameRange) / 2.0f;
+    float centerVal = frameRange.minValue + midVal;
+    float scale = 1.0f / midVal;
+    float sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += (samples[i] - centerVal) * scale;
+    }
+    return sum;
+}
+
+/// @brief The second pass the noise gate's RMS used to take over the unpacked
+/// samples.
+static float samples_rms(const int16_t *samples, size_t count) {
+    int64_t sum = 0;
+    int64_t sumOfSquares = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t value = samples[i];
+        sum += value;
+        sumOfSquares += value * value;
+    }
+    float mean = (float)sum / count;
+    float meanSquare = (float)sumOfSquares / count - mean * mean;
+    return meanSquare > 0 ? sqrtf(meanSquare) : 0;
+}
+
+/// @brief `frame_fused_int16()` plus the RMS from the kernel's sums (what
+/// `PitchPipeline` does).
+static float frame_fused_rms(const uint8_t *adcBuffer, size_t numBytes, int16_t *samples, float *rms) {
+    size_t count = numBytes / sizeof(uint16_t);
+    AdcFrameRange frameRange = adc_unpack_frame_int16((const uint16_t *)adcBuffer, count, samples);
+    *rms = adc_frame_range_rms(frameRange);
+
+    float midVal = adc_frame_range_peak_to_peak(frameRange) / 2.0f;
+    float centerVal = frameRange.minValue + midVal;
+    float scale = 1.0f / midVal;
+    float sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += (samples[i] - centerVal) * scale;
+    }
+    return sum;
+}
+
+/// @brief `frame_fused_int16()` plus the RMS from a second pass.
+static float frame_second_pass_rms(const uint8_t *adcBuffer, size_t numBytes, int16_t *samples, float *rms) {
+    size_t count = numBytes / sizeof(uint16_t);
+    float sum = frame_fused_int16(adcBuffer, numBytes, samples);
+    *rms = samples_rms(samples, count);
+    return sum;
+}
+
+/// @brief `adc_unpack_frame_float()` followed by the same multiply.
+static float frame_fused_float(const uint8_t *adcBuffer, size_t numBytes, float *samples) {
+    size_t count = numBytes / sizeof(uint16_t);
+    AdcFrameRange frameRange = adc_unpack_frame_float((const uint16_t *)adcBuffer, count, samples);
+
+    float midVal = adc_frame_range_peak_to_peak(frameRange) / 2.0f;
+    float centerVal = frameRange.minValue + midVal;
+    float scale = 1.0f / midVal;
+    float sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += (samples[i] - centerVal) * scale;
+    }
+    return sum;
+}
+
+template <typename Kernel>
+static double time_kernel(const char *name, Kernel kernel, size_t frames, double baselineNs) {
+    auto start = std::chrono::steady_clock::now();
+    float sum = 0;
+    for (size_t i = 0; i < frames; i++) {
+        sum += kernel();
+    }
+    auto end = std::chrono::steady_clock::now();
+    benchSink = sum;
+
+    double nsPerFrame = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+    double speedup = baselineNs > 0 ? baselineNs / nsPerFrame : 1.0;
+    printf("  %-12s %10.1f ns/frame %8.2f ns/sample %7.2fx\n", name, nsPerFrame, nsPerFrame / TUNER_ADC_FRAME_SAMPLES, speedup);
+    return nsPerFrame;
+}
+
+int main(int argc, char **argv) {
+    size_t frames = argc > 1 ? (size_t)atol(argv[1]) : KERNEL_BENCH_DEFAULT_FRAMES;
+    if (frames == 0) {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return 2;
+    }
+
+    // A 110 Hz tone at half scale with a little noise, tagged with ADC1
+    // channel 7 the way the CYD's conversion results come in.
+    std::vector<uint16_t> words(TUNER_ADC_FRAME_SAMPLES);
+    srand(1);
+    for (size_t i = 0; i < words.size(); i++) {
+        float value = ADC_TYPE1_MID_VALUE + 1000.0f * sinf(2.0f * (float)M_PI * 110.0f * i / TUNER_ADC_SAMPLE_RATE) + (rand() % 17 - 8);
+        words[i] = (uint16_t)value | (7 << 12);
+    }
+    const uint8_t *adcBuffer = (const uint8_t *)words.data();
+    size_t numBytes = words.size() * sizeof(uint16_t);
+
+    std::vector<float> floatScratch(TUNER_ADC_FRAME_SAMPLES);
+    std::vector<int16_t> int16Scratch(TUNER_ADC_FRAME_SAMPLES);
+
+    // All three have to produce the same samples before their times mean anything
+    float expected = frame_two_pass(adcBuffer, numBytes, floatScratch.data());
+    float fusedInt16 = frame_fused_int16(adcBuffer, numBytes, int16Scratch.data());
+    float fusedFloat = frame_fused_float(adcBuffer, numBytes, floatScratch.data());
+    if (fabsf(fusedInt16 - expected) > 1e-3f || fabsf(fusedFloat - expected) > 1e-3f) {
+        fprintf(stderr, "kernel mismatch: two-pass %f, int16 %f, float %f\n", expected, fusedInt16, fusedFloat);
+        return 1;
+    }
+    float fusedRms = 0;
+    float secondPassRms = 0;
+    frame_fused_rms(adcBuffer, numBytes, int16Scratch.data(), &fusedRms);
+    frame_second_pass_rms(adcBuffer, numBytes, int16Scratch.data(), &secondPassRms);
+    if (fusedRms != secondPassRms) {
+        fprintf(stderr, "RMS mismatch: fused %f, second pass %f\n", fusedRms, secondPassRms);
+        return 1;
+    }
+
+    printf("%zu frames of %d bytes (%d samples)\n", frames, TUNER_ADC_FRAME_SIZE, TUNER_ADC_FRAME_SAMPLES);
+    double baselineNs = time_kernel("two-pass", [&]() {
+        return frame_two_pass(adcBuffer, numBytes, floatScratch.data());
+    }, frames, 0);
+    time_kernel("fused-int16", [&]() {
+        return frame_fused_int16(adcBuffer, numBytes, int16Scratch.data());
+    }, frames, baselineNs);
+    time_kernel("fused-float", [&]() {
+        return frame_fused_float(adcBuffer, numBytes, floatScratch.data());
+    }, frames, baselineNs);
+    time_kernel("fused-rms", [&]() {
+        float rms;
+        return frame_fused_rms(adcBuffer, numBytes, int16Scratch.data(), &rms) + rms;
+    }, frames, baselineNs);
+    time_kernel("2nd-pass-rms", [&]() {
+        float rms;
+        return frame_second_pass_rms(adcBuffer, numBytes, int16Scratch.data(), &rms) + rms;
+    }, frames, baselineNs);
+
+    return 0;
+}
@@ -0,0 +1,543 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Offline pitch detection benchmark.
+ *
+ * Runs labelled guitar/bass WAV recordings through the same PitchPipeline the
+ * firmware uses and reports throughput, note-onset-to-stable-reading latency,
+ * and cents error. See README.md in this directory.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <string>
+#include <vector>
+
+#include "defines.h"
+#include "detector_profiles.h"
+#include "pitch_pipeline.h"
+#include "sample_ring.h"
+
+#include "ground_truth.h"
+#include "wav_file.h"
+
+#define ADC_MAX_VALUE       4095.0f
+#define ADC_MID_VALUE       2048.0f
+#define ADC_CHANNEL_BITS    7       // ADC1 channel 7 (GPIO 35), the CYD's input
+
+typedef struct {
+    size_t  frameSize;      // Samples per frame (the ADC driver hands over TUNER_ADC_FRAME_SIZE bytes, 2 bytes per sample)
+    size_t  windowSize;     // Analysis window (0 means the same as frameSize, so no overlap)
+    uint32_t decimation;    // Passed through as PitchPipelineConfig::decimationFactor
+    float   lowestFrequency; // Passed through as PitchPipelineConfig::lowestFrequency (0 keeps the default)
+    const DetectorProfile *profile; // Picked with --profile (NULL if not)
+    bool    useOctaveGuard; // Passed through as ReadingChainSettings::useOctaveGuard
+    bool    use1EUFilterFirst;
+    float   adcGain;        // 1.0 means a full-scale WAV uses the full 12-bit ADC range
+    float   clockCorrection; // Passed through as PitchPipelineConfig::sampleClockCorrection
+    float   calibrateHz;    // > 0 measures the clock correction from a reference tone instead of benchmarking
+    float   holdMs;         // Passed through as PitchPipelineConfig::relockHoldMs
+    float   expSmoothing;
+    float   oneEUBeta;
+    float   stableCents;    // A reading this close to the truth counts toward "stable"
+    int     stableCount;    // This many in-tolerance readings in a row make a stable reading
+    float   maxCents;       // Gate: fail if the mean absolute cents error is larger (< 0 disables)
+    float   maxLatencyMs;   // Gate: fail if the mean latency is larger (< 0 disables)
+} BenchOptions;
+
+typedef struct {
+    double  timeSeconds;
+    float   frequency;
+} BenchReading;
+
+typedef struct {
+    GroundTruthNote truth;
+    bool            isStable;
+    double          latencyMs;
+    double          meanAbsCents;
+    double          p95AbsCents;
+    size_t          readingCount;
+} NoteResult;
+
+typedef struct {
+    size_t                  sampleCount;
+    double                  audioSeconds;
+    double                  processingSeconds;
+    std::vector<NoteResult> notes;
+    PitchOnsetStats         onsetStats;
+    float                   sampleRate;
+} FileResult;
+
+static void bench_reading_cb(const PitchReading *reading, void *userData) {
+    std::vector<BenchReading> *readings = (std::vector<BenchReading> *)userData;
+    readings->push_back({ reading->timeUs / 1000000.0, reading->frequency });
+}
+
+static double cents_between(double frequency, double reference) {
+    return 1200.0 * log2(frequency / reference);
+}
+
+static double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)std::ceil(fraction * values.size()) - 1;
+    return values[std::min(index, values.size() - 1)];
+}
+
+static NoteResult evaluate_note(const GroundTruthNote &truth, const std::vector<BenchReading> &readings, const BenchOptions &options) {
+    NoteResult result = {};
+    result.truth = truth;
+
+    std::vector<const BenchReading *> window;
+    for (const BenchReading &reading : readings) {
+        if (reading.timeSeconds >= truth.onsetSeconds && reading.timeSeconds < truth.endSeconds) {
+            window.push_back(&reading);
+        }
+    }
+
+    // Find the first reading that starts a run of `stableCount` in-tolerance readings.
+    size_t stableIndex = window.size();
+    int run = 0;
+    for (size_t i = 0; i < window.size(); i++) {
+        if (fabs(cents_between(window[i]->frequency, truth.frequency)) <= options.stableCents) {
+            run++;
+            if (run == options.stableCount) {
+                stableIndex = i + 1 - run;
+                break;
+            }
+        } else {
+            run = 0;
+        }
+    }
+
+    if (stableIndex == window.size()) {
+        return result;
+    }
+
+    std::vector<double> errors;
+    double errorSum = 0;
+    for (size_t i = stableIndex; i < window.size(); i++) {
+        double error = fabs(cents_between(window[i]->frequency, truth.frequency));
+        errors.push_back(error);
+        errorSum += error;
+    }
+
+    result.isStable = true;
+    result.latencyMs = (window[stableIndex]->timeSeconds - truth.onsetSeconds) * 1000.0;
+    result.meanAbsCents = errorSum / errors.size();
+    result.p95AbsCents = percentile(errors, 0.95);
+    result.readingCount = errors.size();
+    return result;
+}
+
+/// @brief Convert a recording into what the ADC would hand the detector.
+///
+/// Type1 results carry the channel in the top 4 bits, so set it like the
+/// firmware's ADC1 channel would be to make sure it gets masked off.
+static std::vector<uint16_t> wav_to_adc_words(const WavFile &wav, const BenchOptions &options) {
+    std::vector<uint16_t> adcSamples(wav.samples.size());
+    for (size_t i = 0; i < wav.samples.size(); i++) {
+        float value = ADC_MID_VALUE + wav.samples[i] * options.adcGain * (ADC_MAX_VALUE - ADC_MID_VALUE);
+        value = std::min(std::max(std::round(value), 0.0f), ADC_MAX_VALUE);
+        adcSamples[i] = (uint16_t)value | (ADC_CHANNEL_BITS << 12);
+    }
+    return adcSamples;
+}
+
+static void raw_frequency_cb(const PitchReading *reading, void *userData) {
+    std::vector<double> *frequencies = (std::vector<double> *)userData;
+    frequencies->push_back(reading->rawFrequency);
+}
+
+/// @brief Measure the sample clock correction from a recording of a known tone.
+///
+/// The WAV's sample rate is taken to be the rate the ADC was asked for (as it
+/// is when a capture is dumped from the device). With no correction, the
+/// detector reads `calibrateHz x asked-for rate / real rate`, so the median
+/// reading gives the correction the device should use.
+static bool calibrate_file(const std::string &wavPath, const BenchOptions &options) {
+    std::string error;
+    WavFile wav;
+    if (!wav_file_load(wavPath, &wav, &error)) {
+        fprintf(stderr, "%s: %s\n", wavPath.c_str(), error.c_str());
+        return false;
+    }
+    std::vector<uint16_t> adcSamples = wav_to_adc_words(wav, options);
+
+    PitchPipelineConfig config = pitch_pipeline_default_config();
+    config.sampleRate = wav.sampleRate;
+    config.sampleClockCorrection = 1.0f;
+    config.maxFrameSize = options.windowSize;
+    config.decimationFactor = options.decimation;
+    if (options.lowestFrequency > 0) {
+        config.lowestFrequency = options.lowestFrequency;
+    }
+    PitchPipeline pipeline(config);
+
+    // Every raw reading counts toward the median. The octave guard would drop
+    // the ones furthest from the reference and pull the median toward it.
+    ReadingChainSettings chainSettings = reading_chain_default_settings();
+    chainSettings.useOctaveGuard = false;
+    pipeline.configureChain(chainSettings);
+
+    // Same windows and hop as run_file(), so the correction is measured the
+    // way the readings it's checked against are made
+    uint32_t ringCapacity = 1;
+    while (ringCapacity < options.windowSize + options.frameSize) {
+        ringCapacity <<= 1;
+    }
+    SampleRing ring(ringCapacity);
+    size_t hop = options.frameSize;
+
+    std::vector<double> frequencies;
+    for (size_t offset = 0; offset < adcSamples.size(); offset += options.frameSize) {
+        size_t count = std::min(options.frameSize, adcSamples.size() - offset);
+        ring.write(&adcSamples[offset], count);
+
+        const uint16_t *window;
+        while ((window = ring.peek(options.windowSize)) != NULL) {
+            size_t firstNewSample = ring.getReadCount() + options.windowSize - hop;
+            int64_t timeUs = (int64_t)(firstNewSample * 1000000.0 / wav.sampleRate);
+            pipeline.processWindow(window, options.windowSize, hop, timeUs, raw_frequency_cb, &frequencies);
+            ring.consume(hop);
+        }
+    }
+    if (frequencies.empty()) {
+        fprintf(stderr, "%s: no readings (is the reference tone loud enough?)\n", wavPath.c_str());
+        return false;
+    }
+
+    double measured = percentile(frequencies, 0.5);
+    printf("%s: %.3f Hz reference read as %.3f Hz (%zu readings)\n", wavPath.c_str(), options.calibrateHz, measured, frequencies.size());
+    printf("  real sample rate %.1f Hz, clock correction %.6f\n", wav.sampleRate * options.calibrateHz / measured, options.calibrateHz / measured);
+    return true;
+}
+
+static bool run_file(const std::string &wavPath, const BenchOptions &options, FileResult *fileResult) {
+    std::string error;
+    WavFile wav;
+    if (!wav_file_load(wavPath, &wav, &error)) {
+        fprintf(stderr, "%s: %s\n", wavPath.c_str(), error.c_str());
+        return false;
+    }
+
+    std::vector<GroundTruthNote> truth;
+    std::string labelPath = ground_truth_path_for_wav(wavPath);
+    if (!ground_truth_load(labelPath, &truth, &error)) {
+        fprintf(stderr, "%s: %s\n", wavPath.c_str(), error.c_str());
+        return false;
+    }
+
+    std::vector<uint16_t> adcSamples = wav_to_adc_words(wav, options);
+    if (options.profile != NULL && wav.sampleRate != options.profile->sampleRate) {
+        fprintf(stderr, "%s: %.0f Hz, but %s samples at %u Hz (resample the WAV to match)\n",
+            wavPath.c_str(), wav.sampleRate, options.profile->name, (unsigned)options.profile->sampleRate);
+    }
+
+    PitchPipelineConfig config = pitch_pipeline_default_config();
+    config.sampleRate = wav.sampleRate;
+    config.sampleClockCorrection = options.clockCorrection;
+    config.maxFrameSize = options.windowSize;
+    config.decimationFactor = options.decimation;
+    config.relockHoldMs = options.holdMs;
+    if (options.lowestFrequency > 0) {
+        config.lowestFrequency = options.lowestFrequency;
+    }
+    PitchPipeline pipeline(config);
+    ReadingChainSettings chainSettings = reading_chain_default_settings();
+    chainSettings.use1EUFilterFirst = options.use1EUFilterFirst;
+    chainSettings.expSmoothing = options.expSmoothing;
+    chainSettings.oneEUBeta = options.oneEUBeta;
+    chainSettings.useOctaveGuard = options.useOctaveGuard;
+    pipeline.configureChain(chainSettings);
+
+    // Frames go through a SampleRing the same way the ADC ISR feeds the
+    // detector task: push a frame, then process every window that's ready.
+    uint32_t ringCapacity = 1;
+    while (ringCapacity < options.windowSize + options.frameSize) {
+        ringCapacity <<= 1;
+    }
+    SampleRing ring(ringCapacity);
+    size_t hop = options.frameSize;
+
+    std::vector<BenchReading> readings;
+    readings.reserve(adcSamples.size() / 16);
+
+    size_t windowCount = 0;
+    size_t gatedCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < adcSamples.size(); offset += options.frameSize) {
+        size_t count = std::min(options.frameSize, adcSamples.size() - offset);
+        ring.write(&adcSamples[offset], count);
+
+        const uint16_t *window;
+        while ((window = ring.peek(options.windowSize)) != NULL) {
+            size_t firstNewSample = ring.getReadCount() + options.windowSize - hop;
+            int64_t timeUs = (int64_t)(firstNewSample * 1000000.0 / wav.sampleRate);
+            PitchFrameResult result = pipeline.processWindow(window, options.windowSize, hop, timeUs, bench_reading_cb, &readings);
+            ring.consume(hop);
+            windowCount++;
+            gatedCount += result == pitchFrameNoSignal ? 1 : 0;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    fileResult->sampleCount = adcSamples.size();
+    fileResult->audioSeconds = adcSamples.size() / wav.sampleRate;
+    fileResult->processingSeconds = std::chrono::duration<double>(end - start).count();
+    for (const GroundTruthNote &note : truth) {
+        fileResult->notes.push_back(evaluate_note(note, readings, options));
+    }
+    fileResult->onsetStats = pipeline.getOnsetStats();
+    fileResult->sampleRate = wav.sampleRate;
+
+    printf("%s (%.0f Hz, detector at %.0f Hz, %.2f s, %zu readings)\n", wavPath.c_str(), wav.sampleRate,
+           wav.sampleRate / options.decimation, fileResult->audioSeconds, readings.size());
+    printf("  throughput: %.0f samples/s (%.1fx real time)\n",
+           fileResult->sampleCount / fileResult->processingSeconds,
+           fileResult->audioSeconds / fileResult->processingSeconds);
+    printf("  noise gate: %zu of %zu windows gated, floor %.1f counts RMS\n", gatedCount, windowCount,
+           pipeline.getNoiseGate().getNoiseFloor());
+    const PitchOnsetStats &onsetStats = fileResult->onsetStats;
+    printf("  first reading: %u cold onsets, %u re-locks, max %.1f ms\n", (unsigned)onsetStats.coldOnsets,
+           (unsigned)onsetStats.relockOnsets, onsetStats.maxSamples * 1000.0 / wav.sampleRate);
+    if (options.useOctaveGuard) {
+        printf("  octave guard: %u corrected, %u rejected\n",
+               (unsigned)pipeline.getOctaveGuard().getCorrectedCount(), (unsigned)pipeline.getOctaveGuard().getRejectedCount());
+    }
+    const ReadingStageStats *stageStats;
+    size_t stageCount = pipeline.getChainStats(&stageStats);
+    for (size_t i = 0; i < stageCount; i++) {
+        if (stageStats[i].readings > 0) {
+            printf("  %-15s %8.1f %s/reading\n", stageStats[i].name,
+                   (double)stageStats[i].cycles / stageStats[i].readings, TUNER_CYCLE_COUNT_UNITS);
+        }
+    }
+    printf("  %10s %10s %12s %10s %10s %9s\n", "onset(s)", "truth(Hz)", "latency(ms)", "mean|c|", "p95|c|", "readings");
+    for (const NoteResult &note : fileResult->notes) {
+        if (note.isStable) {
+            printf("  %10.3f %10.2f %12.1f %10.2f %10.2f %9zu\n", note.truth.onsetSeconds, note.truth.frequency,
+                   note.latencyMs, note.meanAbsCents, note.p95AbsCents, note.readingCount);
+        } else {
+            printf("  %10.3f %10.2f %12s %10s %10s %9s\n", note.truth.onsetSeconds, note.truth.frequency,
+                   "MISSED", "-", "-", "-");
+        }
+    }
+    return true;
+}
+
+static void print_usage(const char *name) {
+    fprintf(stderr,
+        "usage: %s [options] file.wav [file.wav ...]\n"
+        "\n"
+        "Each WAV needs a label file next to it with the same name and a .csv\n"
+        "extension containing onset_seconds,end_seconds,frequency_hz lines.\n"
+        "\n"
+        "options:\n"
+        "  --profile P           frame, window, decimation, and lowest pitch of a detector\n"
+        "                        profile (low, standard, or bass; later options override it)\n"
+        "  --frame N             samples per frame, the detector's hop (default %d)\n"
+        "  --window W            analysis window in samples, >= N (default N)\n"
+        "  --decimate M          run the detector at 1/M of the WAV's rate (default %d)\n"
+        "  --hold-ms H           keep the detector's state H ms after the gate closes (default %.0f)\n"
+        "  --no-octave-guard     pass harmonic jumps straight to the filters\n"
+        "  --exp-first           exponential smoothing before the 1EU filter\n"
+        "  --adc-gain G          scale WAV samples into the 12-bit ADC range (default 1.0)\n"
+        "  --clock-correction C  real / nominal sample rate (default 1.0, device default %.6f)\n"
+        "  --calibrate HZ        print the clock correction from WAVs of a HZ reference tone\n"
+        "  --exp-smoothing A     exponential smoothing amount (default %.3f)\n"
+        "  --one-eu-beta B       1EU filter beta (default %.3f)\n"
+        "  --stable-cents C      tolerance for a stable reading (default 5)\n"
+        "  --stable-count K      consecutive readings for a stable reading (default 5)\n"
+        "  --max-cents X         fail if the mean absolute cents error exceeds X\n"
+        "  --max-latency-ms Y    fail if the mean onset-to-stable latency exceeds Y\n",
+        name, TUNER_ADC_FRAME_SAMPLES, TUNER_DETECTOR_DECIMATION_FACTOR, TUNER_RELOCK_HOLD_MS, DEFAULT_SAMPLE_CLOCK_CORRECTION,
+        DEFAULT_EXP_SMOOTHING, DEFAULT_ONE_EU_BETA);
+}
+
+/// @brief The detector profile whose name starts with `name` (ignoring case).
+static const DetectorProfile *find_profile(const char *name) {
+    for (uint8_t i = 0; i < detectorProfileCount; i++) {
+        const DetectorProfile *profile = detector_profile_get(i);
+        if (strncasecmp(profile->name, name, strlen(name)) == 0) {
+            return profile;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options = {
+        .frameSize = TUNER_ADC_FRAME_SAMPLES,
+        .windowSize = 0,
+        .decimation = TUNER_DETECTOR_DECIMATION_FACTOR,
+        .lowestFrequency = 0,
+        .profile = NULL,
+        .useOctaveGuard = TUNER_OCTAVE_GUARD_ENABLED,
+        .use1EUFilterFirst = DEFAULT_USE_1EU_FILTER_FIRST,
+        .adcGain = 1.0f,
+        .clockCorrection = 1.0f, // WAV files are recorded at their true sample rate
+        .calibrateHz = 0,
+        .holdMs = TUNER_RELOCK_HOLD_MS,
+        .expSmoothing = DEFAULT_EXP_SMOOTHING,
+        .oneEUBeta = DEFAULT_ONE_EU_BETA,
+        .stableCents = 5.0f,
+        .stableCount = 5,
+        .maxCents = -1,
+        .maxLatencyMs = -1,
+    };
+    std::vector<std::string> wavPaths;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--profile") == 0 && hasValue) {
+            options.profile = find_profile(argv[++i]);
+            if (options.profile == NULL) {
+                print_usage(argv[0]);
+                return 2;
+            }
+            options.frameSize = options.profile->frameSamples;
+            options.windowSize = options.profile->windowSamples;
+            options.decimation = options.profile->decimationFactor;
+            options.lowestFrequency = options.profile->lowestFrequency;
+        } else if (strcmp(arg, "--frame") == 0 && hasValue) {
+            options.frameSize = (size_t)std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--window") == 0 && hasValue) {
+            options.windowSize = (size_t)std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--hold-ms") == 0 && hasValue) {
+            options.holdMs = std::max(0.0f, (float)atof(argv[++i]));
+        } else if (strcmp(arg, "--decimate") == 0 && hasValue) {
+            options.decimation = (uint32_t)std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--no-octave-guard") == 0) {
+            options.useOctaveGuard = false;
+        } else if (strcmp(arg, "--exp-first") == 0) {
+            options.use1EUFilterFirst = false;
+        } else if (strcmp(arg, "--adc-gain") == 0 && hasValue) {
+            options.adcGain = atof(argv[++i]);
+        } else if (strcmp(arg, "--clock-correction") == 0 && hasValue) {
+            options.clockCorrection = atof(argv[++i]);
+        } else if (strcmp(arg, "--calibrate") == 0 && hasValue) {
+            options.calibrateHz = atof(argv[++i]);
+        } else if (strcmp(arg, "--exp-smoothing") == 0 && hasValue) {
+            options.expSmoothing = atof(argv[++i]);
+        } else if (strcmp(arg, "--one-eu-beta") == 0 && hasValue) {
+            options.oneEUBeta = atof(argv[++i]);
+        } else if (strcmp(arg, "--stable-cents") == 0 && hasValue) {
+            options.stableCents = atof(argv[++i]);
+        } else if (strcmp(arg, "--stable-count") == 0 && hasValue) {
+            options.stableCount = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--max-cents") == 0 && hasValue) {
+            options.maxCents = atof(argv[++i]);
+        } else if (strcmp(arg, "--max-latency-ms") == 0 && hasValue) {
+            options.maxLatencyMs = atof(argv[++i]);
+        } else if (arg[0] == '-') {
+            print_usage(argv[0]);
+            return 2;
+        } else {
+            wavPaths.push_back(arg);
+        }
+    }
+
+    if (wavPaths.empty()) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    options.windowSize = std::max(options.windowSize, options.frameSize);
+
+    if (options.calibrateHz > 0) {
+        for (const std::string &path : wavPaths) {
+            if (!calibrate_file(path, options)) {
+                return 2;
+            }
+        }
+        return 0;
+    }
+
+    size_t totalSamples = 0;
+    double totalProcessingSeconds = 0;
+    std::vector<double> latencies;
+    std::vector<double> meanErrors;
+    size_t missedNotes = 0;
+    double coldOnsetMs = 0;
+    double relockMs = 0;
+    size_t coldOnsets = 0;
+    size_t relocks = 0;
+
+    for (const std::string &path : wavPaths) {
+        FileResult result;
+        if (!run_file(path, options, &result)) {
+            return 2;
+        }
+        totalSamples += result.sampleCount;
+        totalProcessingSeconds += result.processingSeconds;
+        coldOnsets += result.onsetStats.coldOnsets;
+        coldOnsetMs += result.onsetStats.coldSamples * 1000.0 / result.sampleRate;
+        relocks += result.onsetStats.relockOnsets;
+        relockMs += result.onsetStats.relockSamples * 1000.0 / result.sampleRate;
+        for (const NoteResult &note : result.notes) {
+            if (note.isStable) {
+                latencies.push_back(note.latencyMs);
+                meanErrors.push_back(note.meanAbsCents);
+            } else {
+                missedNotes++;
+            }
+        }
+    }
+
+    double meanLatency = 0;
+    for (double latency : latencies) {
+        meanLatency += latency;
+    }
+    meanLatency = latencies.empty() ? 0 : meanLatency / latencies.size();
+
+    double meanCents = 0;
+    for (double error : meanErrors) {
+        meanCents += error;
+    }
+    meanCents = meanErrors.empty() ? 0 : meanCents / meanErrors.size();
+
+    printf("\nSUMMARY\n");
+    printf("  throughput:      %.0f samples/s\n", totalSamples / totalProcessingSeconds);
+    printf("  notes:           %zu stable, %zu missed\n", latencies.size(), missedNotes);
+    printf("  latency (ms):    mean %.1f, p95 %.1f\n", meanLatency, percentile(latencies, 0.95));
+    printf("  cents error:     mean %.2f, p95 %.2f (per-note mean |cents|)\n", meanCents, percentile(meanErrors, 0.95));
+    printf("  first reading:   mean %.1f ms after %zu cold onsets, %.1f ms after %zu re-locks\n",
+           coldOnsets > 0 ? coldOnsetMs / coldOnsets : 0, coldOnsets, relocks > 0 ? relockMs / relocks : 0, relocks);
+
+    bool failed = false;
+    if (options.maxCents >= 0 && (meanCents > options.maxCents || missedNotes > 0)) {
+        printf("FAIL: mean cents error %.2f exceeds %.2f or notes were missed\n", meanCents, options.maxCents);
+        failed = true;
+    }
+    if (options.maxLatencyMs >= 0 && meanLatency > options.maxLatencyMs) {
+        printf("FAIL: mean latency %.1f ms exceeds %.1f ms\n", meanLatency, options.maxLatencyMs);
+        failed = true;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Equivalence check and microbenchmark for the numeric policies in
+ * main/utils/numeric_policy.hpp.
+ *
+ * Every stage of the reading chain (normalization, exponential smoothing, the
+ * 1EU filter, and cents) is run in float and fixed point and compared against
+ * a double-precision reference. The tool exits with status 1 if either policy
+ * is further from the reference than the tolerances below, then prints how
+ * long each variant takes. CachedOneEuroFilter is checked and timed in each of
+ * its value types against OneEuroFilter.cpp (the original double-precision
+ * filter the firmware used to run, kept here as the reference), and
+ * ExponentialSmoother (in the policy set in defines.h) is checked against the
+ * EMA equation. The reading filters in reading_filters.hpp are checked against
+ * sorting each window.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+
+#include "defines.h"
+#include "adc_frame_kernels.h"
+#include "cached_one_euro_filter.hpp"
+#include "exponential_smoother.hpp"
+#include "numeric_policy.hpp"
+#include "OneEuroFilter.h"
+#include "reading_filters.hpp"
+
+#define NUMERIC_BENCH_DEFAULT_ITERATIONS    2000
+#define NUMERIC_BENCH_SAMPLE_RATE           48000.0
+
+// Tolerances against the double-precision reference
+#define NORMALIZE_TOLERANCE     (2.0 / Q15_ONE) // Two Q15 steps
+#define CENTS_TOLERANCE         0.05            // Cents
+#define SMOOTHING_TOLERANCE     0.05            // Cents
+
+static volatile float benchSink;
+
+static double cents_between(double frequency, double reference) {
+    return 1200.0 * log2(frequency / reference);
+}
+
+/// @brief A 110 Hz ADC frame with some noise, already unpacked to int16.
+static std::vector<int16_t> make_frame(AdcFrameRange *range) {
+    std::vector<uint16_t> words(TUNER_ADC_FRAME_SAMPLES);
+    for (size_t i = 0; i < words.size(); i++) {
+        float value = ADC_TYPE1_MID_VALUE + 1000.0f * sinf(2.0f * (float)M_PI * 110.0f * i / TUNER_ADC_SAMPLE_RATE) + (rand() % 17 - 8);
+        words[i] = (uint16_t)value;
+    }
+    std::vector<int16_t> samples(words.size());
+    *range = adc_unpack_frame_int16(words.data(), words.size(), samples.data());
+    return samples;
+}
+
+/// @brief A wandering pitch around `center` with vibrato and jitter, one
+/// reading per period. Readings land on whole samples like the detector's do.
+static std::vector<float> make_readings(float center, size_t count, std::vector<double> *timestamps, std::vector<uint64_t> *sampleIndices) {
+    std::vector<float> readings(count);
+    uint64_t sampleIndex = 0;
+    for (size_t i = 0; i < count; i++) {
+        float frequency = center * powf(2.0f, (10.0f * sinf(i * 0.01f) + (rand() % 200 - 100) * 0.02f) / 1200.0f);
+        readings[i] = frequency;
+        sampleIndex += (uint64_t)lround(NUMERIC_BENCH_SAMPLE_RATE / frequency);
+        (*sampleIndices)[i] = sampleIndex;
+        (*timestamps)[i] = sampleIndex / NUMERIC_BENCH_SAMPLE_RATE;
+    }
+    return readings;
+}
+
+template <typename Policy>
+static double check_normalize(const std::vector<int16_t> &samples, AdcFrameRange range) {
+    typename Policy::Normalizer normalizer = Policy::normalizer(range.minValue, range.maxValue);
+    double center = (range.minValue + range.maxValue) / 2.0;
+    double halfRange = (range.maxValue - range.minValue) / 2.0;
+    double worst = 0;
+    for (int16_t sample : samples) {
+        double expected = (sample - center) / halfRange;
+        double actual = Policy::toDetector(Policy::normalize(normalizer, sample));
+        worst = std::max(worst, fabs(actual - expected));
+    }
+    return worst;
+}
+
+/// @brief A flat window (min == max) has to normalize to silence, not NaN
+/// or a divide by zero.
+template <typename Policy>
+static double check_normalize_flat() {
+    typename Policy::Normalizer normalizer = Policy::normalizer(2048, 2048);
+    double actual = Policy::toDetector(Policy::normalize(normalizer, 2048));
+    return std::isfinite(actual) ? fabs(actual) : INFINITY;
+}
+
+template <typename Policy>
+static double check_cents() {
+    double worst = 0;
+    for (double frequency = 20.0; frequency < 5000.0; frequency *= 1.0007) {
+        double expected = cents_between(frequency, A4_FREQ);
+        double actual = Policy::centsFromA4((float)frequency);
+        worst = std::max(worst, fabs(actual - expected));
+    }
+    return worst;
+}
+
+template <typename Policy>
+static double check_smoothing(const std::vector<float> &readings, float amount) {
+    typename Policy::coeff_t alpha = Policy::coeff(amount);
+    typename Policy::value_t value = Policy::fromHz(readings[0]);
+    double reference = readings[0];
+    double worst = 0;
+    for (float reading : readings) {
+        value = Policy::blend(Policy::fromHz(reading), value, alpha);
+        reference = amount * reading + (1.0 - amount) * reference;
+        worst = std::max(worst, fabs(cents_between(Policy::toHz(value), reference)));
+    }
+    return worst;
+}
+
+/// @brief ExponentialSmoother against `s = a * x + (1 - a) * s`, with the amount
+/// changed halfway through like a live UserSettings::expSmoothing change, and a
+/// reset at the end. Returns a huge error if a reset doesn't pass the next
+/// value straight through.
+static double check_exponential_smoother(const std::vector<float> &readings) {
+    ExponentialSmoother smoother(DEFAULT_EXP_SMOOTHING);
+    double amount = DEFAULT_EXP_SMOOTHING;
+    double reference = readings[0];
+    double worst = 0;
+    for (size_t i = 0; i < readings.size(); i++) {
+        if (i == readings.size() / 2) {
+            amount = 0.5;
+            smoother.setAmount((float)amount);
+        }
+        if (i > 0) {
+            reference = amount * readings[i] + (1.0 - amount) * reference;
+        }
+        worst = std::max(worst, fabs(cents_between(smoother.smooth(readings[i]), reference)));
+    }
+
+    smoother.reset();
+    if (fabs(cents_between(smoother.smooth(readings[0]), readings[0])) > CENTS_TOLERANCE) {
+        return INFINITY;
+    }
+    return worst;
+}
+
+template <typename T>
+static double check_cached_one_euro(const std::vector<float> &readings, const std::vector<double> &timestamps, const std::vector<uint64_t> &sampleIndices) {
+    typedef OneEuroMath<T> Math;
+    CachedOneEuroFilter<T> filter(NUMERIC_BENCH_SAMPLE_RATE, EU_FILTER_MIN_CUTOFF, DEFAULT_ONE_EU_BETA, EU_FILTER_DERIVATIVE_CUTOFF);
+    OneEuroFilter reference(EU_FILTER_ESTIMATED_FREQ, EU_FILTER_MIN_CUTOFF, DEFAULT_ONE_EU_BETA, EU_FILTER_DERIVATIVE_CUTOFF);
+    double worst = 0;
+    for (size_t i = 0; i < readings.size(); i++) {
+        double expected = reference.filter(readings[i], timestamps[i]);
+        double actual;
+        if constexpr (std::is_same<T, q16_t>::value) {
+            actual = q16_to_float(filter.filter(q16_from_float(readings[i]), sampleIndices[i]));
+        } else {
+            actual = filter.filter((typename Math::value_t)readings[i], sampleIndices[i]);
+        }
+        worst = std::max(worst, fabs(cents_between(actual, expected)));
+    }
+    return worst;
+}
+
+/// @brief The last `windowSize` readings up to and including `end`.
+static std::vector<float> reference_window(const std::vector<float> &readings, size_t start, size_t end, size_t windowSize) {
+    size_t first = end + 1 - std::min(windowSize, end + 1 - start);
+    return std::vector<float>(readings.begin() + first, readings.begin() + end + 1);
+}
+
+static double reference_median(std::vector<float> window) {
+    std::sort(window.begin(), window.end());
+    size_t middle = window.size() / 2;
+    if (window.size() % 2 == 0) {
+        return (window[middle - 1] + window[middle]) / 2.0;
+    }
+    return window[middle];
+}
+
+/// @brief MovingAverage and RunningMedian against recomputing each window from
+/// scratch, for every window size, with the size changed partway through.
+static double check_moving_filters(const std::vector<float> &readings) {
+    double worst = 0;
+    for (size_t windowSize = 1; windowSize <= TUNER_READING_FILTER_MAX_WINDOW; windowSize++) {
+        MovingAverage average(windowSize);
+        RunningMedian median(windowSize);
+        size_t start = 0;
+        size_t size = windowSize;
+        for (size_t i = 0; i < 2000; i++) {
+            if (i == 1000) {
+                // Like a live UserSettings::readingFilterWindow change
+                size = TUNER_READING_FILTER_MAX_WINDOW + 1 - windowSize;
+                average.setWindowSize(size);
+                median.setWindowSize(size);
+                if (size != windowSize) {
+                    start = i;
+                }
+            }
+            std::vector<float> window = reference_window(readings, start, i, size);
+            double mean = 0;
+            for (float value : window) {
+                mean += value;
+            }
+            mean /= window.size();
+            worst = std::max(worst, fabs(cents_between(average.addValue(readings[i]), mean)));
+            worst = std::max(worst, fabs(cents_between(median.addValue(readings[i]), reference_median(window))));
+        }
+    }
+    return worst;
+}
+
+/// @brief Every few readings jumps an octave. The Hampel filter has to put
+/// the window's median in their place. Other readings can come out as either
+/// themselves or the median (the jitter occasionally trips the threshold too).
+static double check_hampel(const std::vector<float> &readings) {
+    const size_t windowSize = 9;
+    HampelFilter hampel(windowSize);
+    std::vector<float> input(readings.begin(), readings.begin() + 2000);
+    for (size_t i = windowSize; i < input.size(); i += 7) {
+        input[i] *= 2;
+    }
+    double worst = 0;
+    for (size_t i = 0; i < input.size(); i++) {
+        double median = reference_median(reference_window(input, 0, i, windowSize));
+        double actual = hampel.addValue(input[i]);
+        double error = fabs(cents_between(actual, median));
+        if (input[i] == readings[i]) {
+            error = std::min(error, fabs(cents_between(actual, input[i])));
+        }
+        worst = std::max(worst, error);
+    }
+    return worst;
+}
+
+template <typename Body>
+static void time_it(const char *name, size_t operations, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    float sum = body();
+    auto end = std::chrono::steady_clock::now();
+    benchSink = sum;
+    double nsPerOperation = std::chrono::duration<double, std::nano>(end - start).count() / operations;
+    printf("  %-24s %8.2f ns/op\n", name, nsPerOperation);
+}
+
+static bool report(const char *name, double worst, double tolerance, const char *units) {
+    bool passed = worst <= tolerance;
+    printf("  %-24s max error %10.6f %-6s (limit %.6f) %s\n", name, worst, units, tolerance, passed ? "ok" : "FAIL");
+    return passed;
+}
+
+int main(int argc, char **argv) {
+    size_t iterations = argc > 1 ? (size_t)atol(argv[1]) : NUMERIC_BENCH_DEFAULT_ITERATIONS;
+    if (iterations == 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    srand(1);
+    AdcFrameRange range;
+    std::vector<int16_t> samples = make_frame(&range);
+    std::vector<double> timestamps(10000);
+    std::vector<uint64_t> sampleIndices(timestamps.size());
+    std::vector<float> readings = make_readings(110.0f, timestamps.size(), &timestamps, &sampleIndices);
+
+    printf("Equivalence with double precision\n");
+    bool passed = true;
+    passed &= report("normalize float", check_normalize<FloatNumericPolicy>(samples, range), NORMALIZE_TOLERANCE, "");
+    passed &= report("normalize fixed", check_normalize<FixedNumericPolicy>(samples, range), NORMALIZE_TOLERANCE, "");
+    passed &= report("normalize flat float", check_normalize_flat<FloatNumericPolicy>(), 0.0, "");
+    passed &= report("normalize flat fixed", check_normalize_flat<FixedNumericPolicy>(), 0.0, "");
+    passed &= report("cents float", check_cents<FloatNumericPolicy>(), CENTS_TOLERANCE, "cents");
+    passed &= report("cents fixed", check_cents<FixedNumericPolicy>(), CENTS_TOLERANCE, "cents");
+    passed &= report("smoothing float", check_smoothing<FloatNumericPolicy>(readings, DEFAULT_EXP_SMOOTHING), SMOOTHING_TOLERANCE, "cents");
+    passed &= report("smoothing fixed", check_smoothing<FixedNumericPolicy>(readings, DEFAULT_EXP_SMOOTHING), SMOOTHING_TOLERANCE, "cents");
+    passed &= report(TUNER_NUMERIC_POLICY == TUNER_NUMERIC_FIXED ? "exp smoother fixed" : "exp smoother float",
+                     check_exponential_smoother(readings), SMOOTHING_TOLERANCE, "cents");
+    passed &= report("cached 1EU double", check_cached_one_euro<double>(readings, timestamps, sampleIndices), SMOOTHING_TOLERANCE, "cents");
+    passed &= report("cached 1EU float", check_cached_one_euro<float>(readings, timestamps, sampleIndices), SMOOTHING_TOLERANCE, "cents");
+    passed &= report("cached 1EU fixed", check_cached_one_euro<q16_t>(readings, timestamps, sampleIndices), SMOOTHING_TOLERANCE, "cents");
+    passed &= report("moving average/median", check_moving_filters(readings), SMOOTHING_TOLERANCE, "cents");
+    passed &= report("hampel", check_hampel(readings), SMOOTHING_TOLERANCE, "cents");
+    if (!passed) {
+        return 1;
+    }
+
+    printf("\nTimings (host; the ESP32 does doubles in software so its gaps are wider)\n");
+    time_it("normalize float", iterations * samples.size(), [&]() {
+        float sum = 0;
+        for (size_t n = 0; n < iterations; n++) {
+            FloatNumericPolicy::Normalizer normalizer = FloatNumericPolicy::normalizer(range.minValue, range.maxValue);
+            for (int16_t sample : samples) {
+                sum += FloatNumericPolicy::toDetector(FloatNumericPolicy::normalize(normalizer, sample));
+            }
+        }
+        return sum;
+    });
+    time_it("normalize fixed", iterations * samples.size(), [&]() {
+        float sum = 0;
+        for (size_t n = 0; n < iterations; n++) {
+            FixedNumericPolicy::Normalizer normalizer = FixedNumericPolicy::normalizer(range.minValue, range.maxValue);
+            for (int16_t sample : samples) {
+                sum += FixedNumericPolicy::toDetector(FixedNumericPolicy::normalize(normalizer, sample));
+            }
+        }
+        return sum;
+    });
+    time_it("cents double", iterations * readings.size(), [&]() {
+        float sum = 0;
+        for (size_t n = 0; n < iterations; n++) {
+            for (float reading : readings) {
+                sum += (float)cents_between(reading, A4_FREQ);
+            }
+        }
+        return sum;
+    });
+    time_it("cents float", iterations * readings.size(), [&]() {
+        float sum = 0;
+        for (size_t n = 0; n < iterations; n++) {
+            for (float reading : readings) {
+                sum += FloatNumericPolicy::centsFromA4(reading);
+            }
+        }
+        return sum;
+    });
+    time_it("cents fixed", iterations * readings.size(), [&]() {
+        float sum = 0;
+        for (size_t n = 0; n < iterations; n++) {
+            for (float reading : readings) {
+                sum += FixedNumericPolicy::centsFromA4(reading);
+            }
+        }
+        return sum;
+    });
+    time_it("1EU filter double", iterations * readings.size(), [&]() {
+        float sum = 0;
+        for (size_t n = 0; n < iterations; n++) {
+            OneEuroFilter filter(EU_FILTER_ESTIMATED_FREQ, EU_FILTER_MIN_CUTOFF, DEFAULT_ONE_EU_BETA, EU_FILTER_DERIVATIVE_CUTOFF);
+            for (size_t i = 0; i < readings.size(); i++) {
+                sum += (float)filter.filter(readings[i], timestamps[i]);
+            }
+        }
+        return sum;
+    });
+    time_it("cached 1EU double", iterations * readings.size(), [&]() {
+        float sum = 0;
+        for (size_t n = 0; n < iterations; n++) {
+            CachedOneEuroFilter<double> filter(NUMERIC_BENCH_SAMPLE_RATE, EU_FILTER_MIN_CUTOFF, DEFAULT_ONE_EU_BETA, EU_FILTER_DERIVATIVE_CUTOFF);
+            for (size_t i = 0; i < readings.size(); i++) {
+                sum += (float)filter.filter(readings[i], sampleIndices[i]);
+            }
+        }
+        return sum;
+    });
+    time_it("cached 1EU float", iterations * readings.size(), [&]() {
+        float sum = 0;
+        for (size_t n = 0; n < iterations; n++) {
+            CachedOneEuroFilter<float> filter(NUMERIC_BENCH_SAMPLE_RATE, EU_FILTER_MIN_CUTOFF, DEFAULT_ONE_EU_BETA, EU_FILTER_DERIVATIVE_CUTOFF);
+            for (size_t i = 0; i < readings.size(); i++) {
+                sum += filter.filter(readings[i], sampleIndices[i]);
+            }
+        }
+        return sum;
+    });
+    time_it("cached 1EU fixed", iterations * readings.size(), [&]() {
+        float sum = 0;
+        for (size_t n = 0; n < iterations; n++) {
+            CachedOneEuroFilter<q16_t> filter(NUMERIC_BENCH_SAMPLE_RATE, EU_FILTER_MIN_CUTOFF, DEFAULT_ONE_EU_BETA, EU_FILTER_DERIVATIVE_CUTOFF);
+            for (size_t i = 0; i < readings.size(); i++) {
+                sum += q16_to_float(filter.filter(q16_from_float(readings[i]), sampleIndices[i]));
+            }
+        }
+        return sum;
+    });
+    for (uint8_t type = readingFilterMovingAverage; type < readingFilterCount; type++) {
+        for (size_t windowSize : { (size_t)5, (size_t)TUNER_READING_FILTER_MAX_WINDOW }) {
+            char name[32];
+            snprintf(name, sizeof(name), "%s (%zu)", reading_filter_names[type], windowSize);
+            time_it(name, iterations * readings.size(), [&]() {
+                float sum = 0;
+                for (size_t n = 0; n < iterations; n++) {
+                    ReadingFilter filter(type, windowSize);
+                    for (float reading : readings) {
+                        sum += filter.filter(reading);
+                    }
+                }
+                return sum;
+            });
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Checks for main/detector/octave_guard.h.
+ *
+ * The first set feeds OctaveGuard made-up reading streams (harmonic and fifth
+ * jumps with low periodicity, real octave and note changes) and checks what
+ * comes out. The second set synthesizes harmonic-rich plucks whose
+ * fundamental dies away faster than the 2nd harmonic, runs them through the
+ * full PitchPipeline with and without the guard, and counts readings that
+ * landed on the wrong harmonic. The tool exits with status 1 if any check
+ * fails or the guard lets more harmonic errors through than running without
+ * it.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "defines.h"
+#include "octave_guard.h"
+#include "pitch_pipeline.h"
+
+#define GUARD_BENCH_SAMPLE_RATE     48000.0f
+#define GUARD_BENCH_NOTE_SECONDS    2.0f
+#define GUARD_BENCH_SETTLE_SECONDS  0.05f   // Readings before this are the attack and aren't counted
+#define GUARD_BENCH_CENTS_TOLERANCE 20.0    // How far a reading can be from the note and still count as right
+#define GUARD_BENCH_WRONG_CENTS     600.0   // Further than this is a harmonic/fifth error
+#define ADC_MAX_VALUE               4095.0f
+#define ADC_MID_VALUE               2048.0f
+
+static double cents_between(double frequency, double reference) {
+    return 1200.0 * log2(frequency / reference);
+}
+
+/// @brief A little detector jitter (+/- 3 cents).
+static float jitter(float frequency) {
+    return frequency * powf(2.0f, (rand() % 600 - 300) * 0.01f / 1200.0f);
+}
+
+static bool report(const char *name, bool passed, const char *detail) {
+    printf("  %-32s %s %s\n", name, passed ? "ok  " : "FAIL", detail);
+    return passed;
+}
+
+/// @brief 110Hz with every 5th reading jumping to a harmonic or fifth at low
+/// periodicity. Nothing that isn't ~110Hz may come out.
+static bool check_harmonic_jumps() {
+    static const float ratios[] = { 2.0f, 3.0f, 0.5f, 1.5f, 4.0f, 2.0f / 3, 1.0f / 3 };
+    OctaveGuard guard;
+    size_t jumps = 0;
+    size_t escaped = 0;
+    size_t corrected = 0;
+    size_t rejected = 0;
+    for (int i = 0; i < 700; i++) {
+        float frequency = jitter(110.0f);
+        float periodicity = 0.95f;
+        bool isJump = i >= TUNER_OCTAVE_GUARD_MIN_HISTORY && i % 5 == 0;
+        if (isJump) {
+            jumps++;
+            frequency *= ratios[(i / 5) % (sizeof(ratios) / sizeof(ratios[0]))];
+            periodicity = 0.6f;
+        }
+        OctaveGuardResult result = guard.check(&frequency, periodicity);
+        corrected += result == octaveGuardCorrected ? 1 : 0;
+        rejected += result == octaveGuardRejected ? 1 : 0;
+        if (result != octaveGuardRejected && fabs(cents_between(frequency, 110.0)) > GUARD_BENCH_CENTS_TOLERANCE) {
+            escaped++;
+        }
+    }
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(%zu escaped, %zu corrected, %zu rejected)", escaped, corrected, rejected);
+    return report("harmonic jumps held", escaped == 0 && corrected + rejected == jumps, detail);
+}
+
+/// @brief 110Hz then 220Hz with high periodicity. The guard has to give in
+/// within TUNER_OCTAVE_GUARD_CONFIRM_READINGS.
+static bool check_octave_change() {
+    OctaveGuard guard;
+    for (int i = 0; i < 50; i++) {
+        float frequency = jitter(110.0f);
+        guard.check(&frequency, 0.95f);
+    }
+    int switchedAt = -1;
+    bool fellBack = false;
+    for (int i = 0; i < 50; i++) {
+        float frequency = jitter(220.0f);
+        OctaveGuardResult result = guard.check(&frequency, 0.98f);
+        bool isNew = result != octaveGuardRejected && fabs(cents_between(frequency, 220.0)) < GUARD_BENCH_CENTS_TOLERANCE;
+        if (isNew && switchedAt < 0) {
+            switchedAt = i;
+        } else if (!isNew && switchedAt >= 0) {
+            fellBack = true;
+        }
+    }
+    char detail[64];
+    snprintf(detail, sizeof(detail), "(after %d readings)", switchedAt + 1);
+    return report("real octave change accepted", switchedAt >= 0 && switchedAt < TUNER_OCTAVE_GUARD_CONFIRM_READINGS && !fellBack, detail);
+}
+
+/// @brief A fourth up (not a harmonic) goes through straight away; a
+/// low-periodicity glitch a few semitones off doesn't.
+static bool check_note_change() {
+    OctaveGuard guard;
+    for (int i = 0; i < 20; i++) {
+        float frequency = jitter(110.0f);
+        guard.check(&frequency, 0.95f);
+    }
+    float glitch = 127.0f;
+    bool glitchRejected = guard.check(&glitch, 0.5f) == octaveGuardRejected;
+    float fourth = 146.83f;
+    bool fourthAccepted = guard.check(&fourth, 0.95f) == octaveGuardAccepted && fourth == 146.83f;
+    return report("note change accepted, glitch not", glitchRejected && fourthAccepted, "");
+}
+
+/// @brief Harmonics 1-8 at 1/k with the fundamental decaying three times as
+/// fast as the rest, converted to type1 ADC words like pitch_bench does.
+static std::vector<uint16_t> make_pluck(float fundamental) {
+    size_t count = (size_t)(GUARD_BENCH_SAMPLE_RATE * GUARD_BENCH_NOTE_SECONDS);
+    std::vector<uint16_t> words(count);
+    for (size_t i = 0; i < count; i++) {
+        float t = i / GUARD_BENCH_SAMPLE_RATE;
+        float value = 0;
+        for (int k = 1; k <= 8 && k * fundamental < GUARD_BENCH_SAMPLE_RATE / 2; k++) {
+            float decay = k == 1 ? 6.0f : 2.0f;
+            value += expf(-decay * t) / k * sinf(2.0f * (float)M_PI * k * fundamental * t);
+        }
+        value = ADC_MID_VALUE + 0.4f * value * (ADC_MAX_VALUE - ADC_MID_VALUE);
+        words[i] = (uint16_t)std::min(std::max(roundf(value), 0.0f), ADC_MAX_VALUE);
+    }
+    return words;
+}
+
+typedef struct {
+    float   fundamental;
+    size_t  readings;
+    size_t  wrong;      // More than GUARD_BENCH_WRONG_CENTS from the fundamental
+} PluckResult;
+
+static void pluck_reading_cb(const PitchReading *reading, void *userData) {
+    PluckResult *result = (PluckResult *)userData;
+    if (reading->timeUs < GUARD_BENCH_SETTLE_SECONDS * 1000000) {
+        return;
+    }
+    result->readings++;
+    if (fabs(cents_between(reading->frequency, result->fundamental)) > GUARD_BENCH_WRONG_CENTS) {
+        result->wrong++;
+    }
+}
+
+static PluckResult run_pluck(const std::vector<uint16_t> &words, float fundamental, bool useOctaveGuard) {
+    PitchPipelineConfig config = pitch_pipeline_default_config();
+    config.sampleRate = GUARD_BENCH_SAMPLE_RATE;
+    config.sampleClockCorrection = 1.0f;
+    PitchPipeline pipeline(config);
+    ReadingChainSettings settings = reading_chain_default_settings();
+    settings.useOctaveGuard = useOctaveGuard;
+    pipeline.configureChain(settings);
+
+    PluckResult result = { fundamental, 0, 0 };
+    size_t frameSize = config.maxFrameSize;
+    for (size_t offset = 0; offset + frameSize <= words.size(); offset += frameSize) {
+        int64_t timeUs = (int64_t)(offset * 1000000.0 / GUARD_BENCH_SAMPLE_RATE);
+        pipeline.processFrame(&words[offset], frameSize, timeUs, pluck_reading_cb, &result);
+    }
+    return result;
+}
+
+int main() {
+    srand(1);
+
+    printf("OctaveGuard reading streams\n");
+    bool passed = true;
+    passed &= check_harmonic_jumps();
+    passed &= check_octave_change();
+    passed &= check_note_change();
+
+    printf("\nSynthetic plucks (readings %.0f+ cents off after the first %.0f ms)\n", GUARD_BENCH_WRONG_CENTS, GUARD_BENCH_SETTLE_SECONDS * 1000);
+    printf("  %10s %20s %20s\n", "note(Hz)", "without guard", "with guard");
+    static const float fundamentals[] = { 41.20f, 82.41f, 110.00f, 146.83f, 196.00f, 329.63f };
+    size_t totalWithout = 0;
+    size_t totalWith = 0;
+    for (float fundamental : fundamentals) {
+        std::vector<uint16_t> words = make_pluck(fundamental);
+        PluckResult without = run_pluck(words, fundamental, false);
+        PluckResult with = run_pluck(words, fundamental, true);
+        printf("  %10.2f %9zu / %-8zu %9zu / %-8zu\n", fundamental, without.wrong, without.readings, with.wrong, with.readings);
+        totalWithout += without.wrong;
+        totalWith += with.wrong;
+    }
+    passed &= report("guard doesn't add errors", totalWith <= totalWithout, "");
+
+    return passed ? 0 : 1;
+}
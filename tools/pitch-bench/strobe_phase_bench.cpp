@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/**
+ * Checks for main/utils/strobe_phase_engine.hpp.
+ *
+ * Made-up reading streams (steady, drifting, irregularly spaced, dropped) are
+ * fed to StrobePhaseEngine and the phase is compared with the beat between
+ * the true pitch and the note integrated in double precision. The phase is
+ * also sampled at several display frame rates to check that it's the same at
+ * every rate and never jumps when a reading arrives. The tool exits with
+ * status 1 if any check fails.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "defines.h"
+#include "strobe_phase_engine.hpp"
+
+#define PHASE_BENCH_READING_US          10000   // Readings arrive about this often
+#define PHASE_BENCH_REFERENCE_STEP_US   10      // Step for the double-precision reference
+#define PHASE_BENCH_TOLERANCE           0.001   // Pattern repeats, for readings of a steady pitch
+#define PHASE_BENCH_DRIFT_TOLERANCE     0.02    // Readings lag a drifting pitch by half an interval
+
+static const int64_t maxHoldUs = TUNER_STROBE_MAX_HOLD_MS * 1000;
+
+/// @brief Cents away from the note at `timeUs`.
+typedef double (*CentsCurve)(int64_t timeUs);
+
+static double steady_cents(int64_t) {
+    return 1.0;
+}
+
+/// @brief A string settling: +10 cents down to in tune over two seconds.
+static double settling_cents(int64_t timeUs) {
+    return timeUs >= 2000000 ? 0.0 : 10.0 * (1.0 - timeUs / 2000000.0);
+}
+
+static double beat_hz(double note, double cents) {
+    return note * exp2(cents / 1200.0) - note;
+}
+
+/// @brief The beat integrated from `fromUs` to `timeUs` in double precision.
+static double reference_phase(double note, CentsCurve curve, int64_t fromUs, int64_t timeUs) {
+    double phase = 0;
+    for (int64_t t = fromUs; t < timeUs; t += PHASE_BENCH_REFERENCE_STEP_US) {
+        int64_t step = std::min((int64_t)PHASE_BENCH_REFERENCE_STEP_US, timeUs - t);
+        phase += beat_hz(note, curve(t + step / 2)) * step / 1000000.0;
+    }
+    return phase;
+}
+
+/// @brief How far apart two phases are (0.0 - 0.5 of a repeat).
+static double phase_error(double a, double b) {
+    double difference = a - b;
+    return fabs(difference - round(difference));
+}
+
+static bool report(const char *name, bool passed, const char *detail) {
+    printf("  %-36s %s %s\n", name, passed ? "ok  " : "FAIL", detail);
+    return passed;
+}
+
+/// @brief Reading times `PHASE_BENCH_READING_US` apart, give or take
+/// `jitterUs`.
+static std::vector<int64_t> reading_times(int64_t durationUs, int64_t jitterUs) {
+    std::vector<int64_t> times;
+    for (int64_t t = 0; t <= durationUs; t += PHASE_BENCH_READING_US) {
+        int64_t jitter = jitterUs > 0 ? rand() % (2 * jitterUs + 1) - jitterUs : 0;
+        times.push_back(std::max(t + jitter, times.empty() ? (int64_t)0 : times.back() + 1));
+    }
+    return times;
+}
+
+/// @brief Feed the readings at `times` (frequency from `curve`) and compare
+/// the phase at the last one with the reference.
+static bool check_accuracy(const char *name, double note, CentsCurve curve, const std::vector<int64_t> &times, double tolerance) {
+    StrobePhaseEngine engine(1000.0f, maxHoldUs); // No speed limit
+    double maxError = 0;
+    for (int64_t t : times) {
+        float cents = (float)curve(t);
+        float frequency = (float)(note * exp2(cents / 1200.0));
+        engine.update(frequency, cents, t);
+        if (t % 1000000 < PHASE_BENCH_READING_US) {
+            maxError = std::max(maxError, phase_error(engine.getPhase(t), reference_phase(note, curve, times.front(), t)));
+        }
+    }
+    int64_t end = times.back();
+    maxError = std::max(maxError, phase_error(engine.getPhase(end), reference_phase(note, curve, times.front(), end)));
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(%.5f repeats off after %.1f s)", maxError, end / 1000000.0);
+    return report(name, maxError <= tolerance, detail);
+}
+
+/// @brief Draw frames between settling readings at several frame rates. At
+/// the same moments every rate has to see the same phase, and no frame may
+/// move further than the beat allows (a reading mustn't make it jump).
+static bool check_frame_rates() {
+    static const int framesPerSecond[] = { 7, 15, 30, 60, 144 };
+    const double note = 329.63;
+    std::vector<int64_t> times = reading_times(3000000, 3000);
+    std::vector<std::vector<float>> probes;
+    double maxJump = 0;
+    for (int fps : framesPerSecond) {
+        StrobePhaseEngine engine(1000.0f, maxHoldUs);
+        std::vector<float> phases;
+        int64_t frameUs = 1000000 / fps;
+        int64_t nextFrameUs = frameUs;
+        float lastPhase = 0;
+        float lastBeat = 0;
+        for (size_t i = 0; i < times.size(); i++) {
+            float cents = (float)settling_cents(times[i]);
+            engine.update((float)(note * exp2(cents / 1200.0)), cents, times[i]);
+            if (i == 0) {
+                lastPhase = engine.getPhase(times[i]);
+                lastBeat = engine.getBeatHz();
+            }
+
+            int64_t nextReadingUs = i + 1 < times.size() ? times[i + 1] : times[i] + frameUs;
+            for (; nextFrameUs < nextReadingUs; nextFrameUs += frameUs) {
+                float phase = engine.getPhase(nextFrameUs);
+                float allowed = std::max(fabsf(lastBeat), fabsf(engine.getBeatHz())) * frameUs / 1000000.0f;
+                maxJump = std::max(maxJump, phase_error(phase, lastPhase) - allowed);
+                lastPhase = phase;
+                lastBeat = engine.getBeatHz();
+            }
+
+            // Halfway to the next reading, every 10th one
+            if (i % 10 == 0 && i + 1 < times.size()) {
+                phases.push_back(engine.getPhase((times[i] + times[i + 1]) / 2));
+            }
+        }
+        probes.push_back(phases);
+    }
+    double maxMismatch = 0;
+    for (const std::vector<float> &phases : probes) {
+        for (size_t i = 0; i < phases.size(); i++) {
+            maxMismatch = std::max(maxMismatch, phase_error(phases[i], probes[0][i]));
+        }
+    }
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(%.6f apart, %.6f past the beat)", maxMismatch, maxJump);
+    return report("same phase at every frame rate", maxMismatch == 0 && maxJump <= 1e-4, detail);
+}
+
+/// @brief With no readings the pattern keeps going for the hold time and
+/// then stops; stopping and starting again doesn't move it.
+static bool check_hold_and_stop() {
+    const float note = 110.0f;
+    const float cents = 5.0f;
+    StrobePhaseEngine engine(1000.0f, maxHoldUs);
+    engine.update(note * exp2f(cents / 1200.0f), cents, 0);
+    float beat = engine.getBeatHz();
+    float held = engine.getPhase(maxHoldUs);
+    float later = engine.getPhase(maxHoldUs + 5000000);
+    bool holds = phase_error(held, beat * maxHoldUs / 1000000.0) < 1e-5 && phase_error(later, held) < 1e-6;
+
+    engine.stop(100000);
+    float stopped = engine.getPhase(100000);
+    bool stopsInPlace = phase_error(stopped, beat * 0.1) < 1e-5 && phase_error(engine.getPhase(900000), stopped) < 1e-6;
+    engine.update(note, 0.0f, 900000);
+    bool restartsInPlace = phase_error(engine.getPhase(900000), stopped) < 1e-6;
+
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(%.0f ms hold)", maxHoldUs / 1000.0);
+    return report("holds, stops, and restarts in place", holds && stopsInPlace && restartsInPlace, detail);
+}
+
+/// @brief A high note far out of tune moves at TUNER_STROBE_MAX_BEAT_HZ,
+/// either way.
+static bool check_speed_limit() {
+    StrobePhaseEngine engine(TUNER_STROBE_MAX_BEAT_HZ, maxHoldUs);
+    engine.update(659.26f * exp2f(40.0f / 1200.0f), 40.0f, 0);
+    bool sharp = engine.getBeatHz() == TUNER_STROBE_MAX_BEAT_HZ;
+    engine.update(659.26f * exp2f(-40.0f / 1200.0f), -40.0f, 10000);
+    bool flat = engine.getBeatHz() == -TUNER_STROBE_MAX_BEAT_HZ;
+    char detail[64];
+    snprintf(detail, sizeof(detail), "(%.1f Hz)", TUNER_STROBE_MAX_BEAT_HZ);
+    return report("beat limited", sharp && flat, detail);
+}
+
+int main() {
+    srand(1);
+
+    printf("StrobePhaseEngine against the integrated beat\n");
+    bool passed = true;
+    passed &= check_accuracy("A4 +1 cent, even readings", 440.0, steady_cents, reading_times(10000000, 0), PHASE_BENCH_TOLERANCE);
+    passed &= check_accuracy("A4 +1 cent, jittery readings", 440.0, steady_cents, reading_times(10000000, 4000), PHASE_BENCH_TOLERANCE);
+    passed &= check_accuracy("E2 +1 cent, jittery readings", 82.41, steady_cents, reading_times(10000000, 4000), PHASE_BENCH_TOLERANCE);
+    passed &= check_accuracy("E4 settling from +10 cents", 329.63, settling_cents, reading_times(3000000, 4000), PHASE_BENCH_DRIFT_TOLERANCE);
+    passed &= check_frame_rates();
+    passed &= check_hold_and_stop();
+    passed &= check_speed_limit();
+
+    // What stepping by the cents every GUI update (the old strobe) did
+    printf("\nDegrees a second at A4 +5 cents (3 repeats per turn)\n");
+    printf("  %6s %16s %16s\n", "fps", "step per update", "phase engine");
+    double engineDegrees = beat_hz(440.0, 5.0) * 360.0 / 3;
+    for (int fps : { 8, 15, 30, 60 }) {
+        printf("  %6d %16.1f %16.1f\n", fps, 5.0 * fps, engineDegrees);
+    }
+
+    return passed ? 0 : 1;
+}
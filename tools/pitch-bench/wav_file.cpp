@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "wav_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#define WAV_FORMAT_PCM          1
+#define WAV_FORMAT_IEEE_FLOAT   3
+#define WAV_FORMAT_EXTENSIBLE   0xFFFE
+
+static uint16_t read_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool wav_file_load(const std::string &path, WavFile *wav, std::string *error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        *error = "unable to open file";
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (bytes.size() < 12 || memcmp(&bytes[0], "RIFF", 4) != 0 || memcmp(&bytes[8], "WAVE", 4) != 0) {
+        *error = "not a RIFF/WAVE file";
+        return false;
+    }
+
+    uint16_t format = 0;
+    uint16_t channels = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 0;
+    const uint8_t *data = NULL;
+    uint32_t dataSize = 0;
+
+    // Walk the chunks looking for "fmt " and "data"
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        const uint8_t *chunk = &bytes[pos];
+        uint32_t chunkSize = read_u32(chunk + 4);
+        const uint8_t *body = chunk + 8;
+        size_t available = bytes.size() - (pos + 8);
+        if (chunkSize > available) {
+            chunkSize = available; // Truncated file. Use what's there.
+        }
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+            format = read_u16(body);
+            channels = read_u16(body + 2);
+            sampleRate = read_u32(body + 4);
+            bitsPerSample = read_u16(body + 14);
+            if (format == WAV_FORMAT_EXTENSIBLE && chunkSize >= 26) {
+                format = read_u16(body + 24); // First two bytes of the sub-format GUID
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            data = body;
+            dataSize = chunkSize;
+        }
+
+        pos += 8 + chunkSize + (chunkSize & 1); // Chunks are padded to an even size
+    }
+
+    if (channels == 0 || sampleRate == 0 || data == NULL) {
+        *error = "missing fmt or data chunk";
+        return false;
+    }
+
+    bool isSupported = (format == WAV_FORMAT_PCM && (bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32))
+        || (format == WAV_FORMAT_IEEE_FLOAT && bitsPerSample == 32);
+    if (!isSupported) {
+        *error = "unsupported sample format (use 16/24/32-bit PCM or 32-bit float)";
+        return false;
+    }
+
+    size_t bytesPerSample = bitsPerSample / 8;
+    size_t frameBytes = bytesPerSample * channels;
+    size_t frameCount = dataSize / frameBytes;
+
+    wav->sampleRate = (float)sampleRate;
+    wav->samples.resize(frameCount);
+
+    for (size_t i = 0; i < frameCount; i++) {
+        const uint8_t *p = data + i * frameBytes; // First channel only
+        float value;
+        if (format == WAV_FORMAT_IEEE_FLOAT) {
+            uint32_t raw = read_u32(p);
+            memcpy(&value, &raw, sizeof(value));
+        } else if (bitsPerSample == 16) {
+            value = (int16_t)read_u16(p) / 32768.0f;
+        } else if (bitsPerSample == 24) {
+            int32_t raw = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+            value = raw / 8388608.0f;
+        } else {
+            value = (int32_t)read_u32(p) / 2147483648.0f;
+        }
+        wav->samples[i] = value;
+    }
+
+    return true;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2024 Boyd Timothy. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#if !defined(PITCH_BENCH_WAV_FILE)
+#define PITCH_BENCH_WAV_FILE
+
+#include <string>
+#include <vector>
+
+/// @brief A mono WAV recording with samples scaled to -1.0 ... +1.0.
+///
+/// Only the first channel of multi-channel files is kept. 16-bit, 24-bit, and
+/// 32-bit PCM as well as 32-bit float files are supported.
+typedef struct {
+    float               sampleRate;
+    std::vector<float>  samples;
+} WavFile;
+
+/// @brief Loads a WAV file from disk.
+/// @param path Path to the file.
+/// @param wav Filled in with the file contents.
+/// @param error Filled in with a description of the problem if loading fails.
+/// @return Returns `true` if the file was loaded.
+bool wav_file_load(const std::string &path, WavFile *wav, std::string *error);
+
+#endif